@@ -0,0 +1,247 @@
+#include "../src/ThreeDModel.h"
+#include "../src/HeadlessPresenter.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+//   :      
+class BenchModel : public ThreeDModel
+{
+private:
+	size_t triangleCount;
+	int cameraPath;
+	uint32_t warmupFrames;
+	uint32_t totalFrames;
+	uint32_t frameIndex;
+	uint64_t maxAllocations;
+
+	void createSphere(Mesh& mesh, size_t triangles)
+	{
+		//  rings x segments  2 * rings * segments 
+		size_t segments = max<size_t>(3, static_cast<size_t>(sqrtf(static_cast<float>(triangles) / 2.0f)));
+		size_t rings = max<size_t>(1, triangles / (2 * segments));
+
+		for (size_t r = 0; r <= rings; r++)
+		{
+			float theta = PI * r / rings;
+			for (size_t s = 0; s < segments; s++)
+			{
+				float phi = 2.0f * PI * s / segments;
+				mesh.vertices.x.push_back(1.0f + sinf(theta) * cosf(phi));
+				mesh.vertices.y.push_back(1.0f + cosf(theta));
+				mesh.vertices.z.push_back(1.0f + sinf(theta) * sinf(phi));
+				mesh.vertices.w.push_back(1.0f);
+			}
+		}
+		for (size_t r = 0; r < rings; r++)
+		{
+			for (size_t s = 0; s < segments; s++)
+			{
+				uint32_t a = static_cast<uint32_t>(r * segments + s);
+				uint32_t b = static_cast<uint32_t>(r * segments + (s + 1) % segments);
+				uint32_t c = static_cast<uint32_t>((r + 1) * segments + (s + 1) % segments);
+				uint32_t d = static_cast<uint32_t>((r + 1) * segments + s);
+				mesh.indices.insert(mesh.indices.end(), { a, b, c, a, c, d });
+			}
+		}
+	}
+
+	virtual void userCreateHandle() override
+	{
+		Mesh mesh;
+		createSphere(mesh, triangleCount);
+		shapes.push_back(move(mesh));
+		ThreeDModel::userCreateHandle();
+		//   ,     
+		getScheduler().setFixedStep(0.0f);
+	}
+
+	virtual bool userUpdateHandle(float /*fElapsedTime*/) override
+	{
+		//       
+		float phase = static_cast<float>(frameIndex) / static_cast<float>(totalFrames);
+		switch (cameraPath)
+		{
+			case 0:
+				thetaY = 4.0f * PI * phase;
+				thetaX = 0.6f * sinf(2.0f * PI * phase);
+				break;
+			case 1:
+				thetaY = PI * phase;
+				coordZ = 4.5f + 2.5f * (0.5f - 0.5f * cosf(2.0f * PI * phase));
+				break;
+			default:
+				break;
+		}
+
+		if (frameIndex == warmupFrames)
+		{
+			profiler.setEnabled(true);
+		}
+		//     ,     
+		if (frameIndex > warmupFrames)
+		{
+			maxAllocations = max(maxAllocations, getFrameAllocations());
+		}
+		frameIndex++;
+		return ThreeDModel::userUpdateHandle(1.0f / 60.0f);
+	}
+
+public:
+	BenchModel(size_t triangleCount, int cameraPath, uint32_t warmupFrames, uint32_t totalFrames)
+	{
+		this->triangleCount = triangleCount;
+		this->cameraPath = cameraPath;
+		this->warmupFrames = warmupFrames;
+		this->totalFrames = totalFrames;
+		frameIndex = 0;
+		maxAllocations = 0;
+	}
+
+	uint64_t getMaxAllocations()
+	{
+		return maxAllocations;
+	}
+};
+
+struct Summary
+{
+	float median, deviation;
+};
+
+static Summary summarise(vector<float> values)
+{
+	Summary summary = { 0.0f, 0.0f };
+	if (values.empty())
+	{
+		return summary;
+	}
+
+	sort(values.begin(), values.end());
+	summary.median = values[values.size() / 2];
+
+	float mean = 0.0f, variance = 0.0f;
+	for (float value : values)
+	{
+		mean += value;
+	}
+	mean /= values.size();
+	for (float value : values)
+	{
+		variance += (value - mean) * (value - mean);
+	}
+	summary.deviation = sqrtf(variance / values.size());
+	return summary;
+}
+
+int main(int argc, char* argv[])
+{
+	size_t maxTriangles = 1000000;
+	uint32_t warmup = 3, frames = 20, repetitions = 5;
+	size_t threads = 1;
+	int cameraPath = 0;
+	int modes = 3;
+	bool lod = false;
+	SUBCELL_MODE subcell = SUBCELL_OFF;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "--max-triangles"))
+		{
+			maxTriangles = strtoull(argv[i + 1], nullptr, 10);
+		}
+		else if (!strcmp(argv[i], "--warmup"))
+		{
+			warmup = atoi(argv[i + 1]);
+		}
+		else if (!strcmp(argv[i], "--frames"))
+		{
+			frames = max(1, atoi(argv[i + 1]));
+		}
+		else if (!strcmp(argv[i], "--repetitions"))
+		{
+			repetitions = max(1, atoi(argv[i + 1]));
+		}
+		else if (!strcmp(argv[i], "--threads"))
+		{
+			threads = atoi(argv[i + 1]);
+		}
+		else if (!strcmp(argv[i], "--path"))
+		{
+			cameraPath = !strcmp(argv[i + 1], "zoom") ? 1 : 0;
+		}
+		else if (!strcmp(argv[i], "--mode"))
+		{
+			modes = !strcmp(argv[i + 1], "painter") ? 1 : (!strcmp(argv[i + 1], "zbuffer") ? 2 : 3);
+		}
+		else if (!strcmp(argv[i], "--subcell"))
+		{
+			subcell = !strcmp(argv[i + 1], "braille") ? SUBCELL_BRAILLE : (!strcmp(argv[i + 1], "half") ? SUBCELL_HALF_BLOCK : SUBCELL_OFF);
+		}
+		else if (!strcmp(argv[i], "--lod"))
+		{
+			lod = !strcmp(argv[i + 1], "on");
+		}
+	}
+
+	const PROFILE_STAGE stages[] = { STAGE_TRANSFORM, STAGE_SORT, STAGE_SHADOW, STAGE_PAINT, STAGE_FILL, STAGE_FRAME };
+	const size_t stageCount = sizeof(stages) / sizeof(stages[0]);
+
+	//  p50     , 
+	printf("%-8s %10s", "mode", "triangles");
+	for (size_t s = 0; s < stageCount; s++)
+	{
+		printf(" %18s", Profiler::stageName(stages[s]));
+	}
+#ifdef KGK_COUNT_ALLOCATIONS
+	printf(" %8s", "allocs");
+#endif
+	printf("\n");
+
+	for (int mode = 0; mode < 2; mode++)
+	{
+		if (!(modes & (1 << mode)))
+		{
+			continue;
+		}
+		for (size_t triangles = 10; triangles <= maxTriangles; triangles *= 10)
+		{
+			vector<float> results[stageCount];
+			uint64_t allocations = 0;
+
+			for (uint32_t r = 0; r < repetitions; r++)
+			{
+				BenchModel model(triangles, cameraPath, warmup, warmup + frames);
+				model.setPresenter(new HeadlessPresenter());
+				model.setFrameLimit(warmup + frames);
+				model.setRenderMode(mode ? RENDER_ZBUFFER : RENDER_PAINTER);
+				model.setThreadCount(threads);
+				model.setLodEnabled(lod);
+				model.setSubcellMode(subcell);
+				if (model.constructConsole(400, 250, 2, 2, L"benchmark"))
+				{
+					return 1;
+				}
+				model.run();
+				for (size_t s = 0; s < stageCount; s++)
+				{
+					results[s].push_back(model.getProfiler().getStats(stages[s]).p50);
+				}
+				allocations = max(allocations, model.getMaxAllocations());
+			}
+
+			printf("%-8s %10zu", mode ? "zbuffer" : "painter", triangles);
+			for (size_t s = 0; s < stageCount; s++)
+			{
+				Summary summary = summarise(results[s]);
+				printf(" %9.3f +-%6.3f", summary.median, summary.deviation);
+			}
+#ifdef KGK_COUNT_ALLOCATIONS
+			printf(" %8llu", static_cast<unsigned long long>(allocations));
+#endif
+			printf("\n");
+			fflush(stdout);
+		}
+	}
+	return 0;
+}
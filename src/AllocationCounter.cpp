@@ -0,0 +1,56 @@
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+atomic<uint64_t> AllocationCounter::allocations(0);
+atomic<uint64_t> AllocationCounter::bytes(0);
+
+#ifdef KGK_COUNT_ALLOCATIONS
+
+void* operator new(size_t size)
+{
+	AllocationCounter::record(size);
+	void* ptr = malloc(size ? size : 1);
+	if (!ptr)
+	{
+		throw bad_alloc();
+	}
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept
+{
+	AllocationCounter::record(size);
+	return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const nothrow_t&) noexcept
+{
+	return operator new(size, nothrow);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+	free(ptr);
+}
+#endif
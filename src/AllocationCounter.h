@@ -0,0 +1,33 @@
+#ifndef _ALLOCATION_COUNTER_H_
+#define _ALLOCATION_COUNTER_H_
+
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+//       operator new/delete.
+//       KGK_COUNT_ALLOCATIONS,    0
+class AllocationCounter
+{
+private:
+	static atomic<uint64_t> allocations;
+	static atomic<uint64_t> bytes;
+
+public:
+	static void record(size_t size)
+	{
+		allocations.fetch_add(1, memory_order_relaxed);
+		bytes.fetch_add(size, memory_order_relaxed);
+	}
+	static uint64_t getAllocations()
+	{
+		return allocations.load(memory_order_relaxed);
+	}
+	static uint64_t getBytes()
+	{
+		return bytes.load(memory_order_relaxed);
+	}
+};
+
+#endif
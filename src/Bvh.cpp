@@ -0,0 +1,177 @@
+#include "Bvh.h"
+#include <algorithm>
+#include <cfloat>
+
+void Bvh::Bounds::reset()
+{
+	for (int16_t i = 0; i < 3; i++)
+	{
+		min[i] = FLT_MAX;
+		max[i] = -FLT_MAX;
+	}
+}
+
+void Bvh::Bounds::expand(const float point[3])
+{
+	for (int16_t i = 0; i < 3; i++)
+	{
+		min[i] = std::min(min[i], point[i]);
+		max[i] = std::max(max[i], point[i]);
+	}
+}
+
+void Bvh::Bounds::expand(const Bounds& obj)
+{
+	for (int16_t i = 0; i < 3; i++)
+	{
+		min[i] = std::min(min[i], obj.min[i]);
+		max[i] = std::max(max[i], obj.max[i]);
+	}
+}
+
+void Bvh::build(const vector<Bounds>& items, uint32_t leafSize)
+{
+	nodes.clear();
+	order.resize(items.size());
+	for (uint32_t i = 0; i < order.size(); i++)
+	{
+		order[i] = i;
+	}
+	if (!items.empty())
+	{
+		nodes.reserve(2 * items.size() / max<uint32_t>(leafSize, 1) + 1);
+		buildNode(items, 0, static_cast<uint32_t>(items.size()), max<uint32_t>(leafSize, 1));
+	}
+	//        32,         
+	stack.reserve(2 * 32 + 2);
+}
+
+uint32_t Bvh::buildNode(const vector<Bounds>& items, uint32_t first, uint32_t count, uint32_t leafSize)
+{
+	uint32_t index = static_cast<uint32_t>(nodes.size());
+	nodes.push_back({});
+
+	Bounds bounds, centers;
+	bounds.reset();
+	centers.reset();
+	for (uint32_t i = first; i < first + count; i++)
+	{
+		const Bounds& item = items[order[i]];
+		float center[3] = { (item.min[0] + item.max[0]) * 0.5f, (item.min[1] + item.max[1]) * 0.5f, (item.min[2] + item.max[2]) * 0.5f };
+		bounds.expand(item);
+		centers.expand(center);
+	}
+	nodes[index].bounds = bounds;
+	nodes[index].first = first;
+	nodes[index].count = count;
+	nodes[index].right = 0;
+
+	if (count <= leafSize)
+	{
+		return index;
+	}
+
+	//         
+	int16_t axis = 0;
+	for (int16_t i = 1; i < 3; i++)
+	{
+		if (centers.max[i] - centers.min[i] > centers.max[axis] - centers.min[axis])
+		{
+			axis = i;
+		}
+	}
+	uint32_t half = count / 2;
+	nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count, [&](uint32_t a, uint32_t b)
+		{
+			return items[a].min[axis] + items[a].max[axis] < items[b].min[axis] + items[b].max[axis];
+		});
+
+	buildNode(items, first, half, leafSize);
+	uint32_t right = buildNode(items, first + half, count - half, leafSize);
+	nodes[index].right = right;
+	return index;
+}
+
+void Bvh::refit(const vector<Bounds>& items)
+{
+	//    ,    
+	for (size_t i = nodes.size(); i-- > 0;)
+	{
+		Node& node = nodes[i];
+		if (node.right == 0)
+		{
+			node.bounds.reset();
+			for (uint32_t k = node.first; k < node.first + node.count; k++)
+			{
+				node.bounds.expand(items[order[k]]);
+			}
+		}
+		else
+		{
+			node.bounds = nodes[i + 1].bounds;
+			node.bounds.expand(nodes[node.right].bounds);
+		}
+	}
+}
+
+void Bvh::query(const float planes[][4], size_t planeCount, vector<Range>& ranges)
+{
+	ranges.clear();
+	if (nodes.empty())
+	{
+		return;
+	}
+	//   ,  ,     
+	ranges.reserve(nodes.size() / 2 + 1);
+
+	auto emit = [&](const Node& node)
+	{
+		if (!ranges.empty() && ranges.back().first + ranges.back().count == node.first)
+		{
+			ranges.back().count += node.count;
+		}
+		else
+		{
+			ranges.push_back({ node.first, node.count });
+		}
+	};
+
+	stack.clear();
+	stack.push_back(0);
+	while (!stack.empty())
+	{
+		uint32_t index = stack.back();
+		const Node& node = nodes[index];
+		stack.pop_back();
+
+		//         
+		bool isOutside = false, isInside = true;
+		for (size_t p = 0; p < planeCount && !isOutside; p++)
+		{
+			const float* plane = planes[p];
+			float nearest = plane[3], farthest = plane[3];
+			for (int16_t i = 0; i < 3; i++)
+			{
+				float low = plane[i] * node.bounds.min[i];
+				float high = plane[i] * node.bounds.max[i];
+				farthest += max(low, high);
+				nearest += min(low, high);
+			}
+			isOutside = farthest < 0.0f;
+			isInside = isInside && nearest >= 0.0f;
+		}
+
+		if (isOutside)
+		{
+			continue;
+		}
+		if (isInside || node.right == 0)
+		{
+			emit(node);
+			continue;
+		}
+		//    ,     
+		stack.push_back(node.right);
+		stack.push_back(index + 1);
+	}
+}
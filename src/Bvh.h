@@ -0,0 +1,62 @@
+#ifndef _BVH_H_
+#define _BVH_H_
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+//       
+class Bvh
+{
+public:
+	struct Bounds
+	{
+		float min[3], max[3];
+
+		void reset();
+		void expand(const float point[3]);
+		void expand(const Bounds& obj);
+	};
+
+	//      
+	struct Range
+	{
+		uint32_t first, count;
+	};
+
+private:
+	//       :     
+	struct Node
+	{
+		Bounds bounds;
+		uint32_t first, count;
+		uint32_t right;
+	};
+
+	vector<Node> nodes;
+	vector<uint32_t> order;
+	vector<uint32_t> stack;
+
+	uint32_t buildNode(const vector<Bounds>& items, uint32_t first, uint32_t count, uint32_t leafSize);
+
+public:
+	void build(const vector<Bounds>& items, uint32_t leafSize);
+	void refit(const vector<Bounds>& items);
+	void query(const float planes[][4], size_t planeCount, vector<Range>& ranges);
+
+	const vector<uint32_t>& getOrder()
+	{
+		return order;
+	}
+	size_t size()
+	{
+		return order.size();
+	}
+	Bounds getBounds()
+	{
+		return nodes.empty() ? Bounds{ { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } } : nodes[0].bounds;
+	}
+};
+
+#endif
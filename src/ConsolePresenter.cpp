@@ -0,0 +1,213 @@
+#include "ConsolePresenter.h"
+#include <cstdio>
+
+ConsolePresenter::ConsolePresenter()
+{
+	consoleWidth = 120;
+	consoleHeight = 60;
+
+	outConsoleHandle = GetStdHandle(STD_OUTPUT_HANDLE);
+	inConsoleHandle = GetStdHandle(STD_INPUT_HANDLE);
+	orgConsoleHandle = outConsoleHandle;
+
+	rectWindow = { 0 };
+}
+
+ConsolePresenter::~ConsolePresenter()
+{
+	SetConsoleActiveScreenBuffer(orgConsoleHandle);
+}
+
+int16_t ConsolePresenter::create(int16_t width, int16_t height, int16_t fontW, int16_t fontH, const wstring& title)
+{
+	if (outConsoleHandle == INVALID_HANDLE_VALUE)
+	{
+		return error(L"Invalid handle value error");
+	}
+	consoleWidth = width;
+	consoleHeight = height;
+
+	rectWindow = { 0, 0, 1, 1 };
+	SetConsoleWindowInfo(outConsoleHandle, TRUE, &rectWindow);
+
+	//   screen buffer
+	COORD coord = { (int16_t)consoleWidth, (int16_t)consoleHeight };
+	if (!SetConsoleScreenBufferSize(outConsoleHandle, coord))
+	{
+		error(L"SetConsoleScreenBufferSize error");
+	}
+	if (!SetConsoleActiveScreenBuffer(outConsoleHandle))
+	{
+		return error(L"SetConsoleActiveScreenBuffer error");
+	}
+
+	//     screen buffer
+	CONSOLE_FONT_INFOEX cfi;
+	cfi.cbSize = sizeof(cfi);
+	cfi.nFont = 0;
+	cfi.dwFontSize.X = fontW;
+	cfi.dwFontSize.Y = fontH;
+	cfi.FontFamily = FF_DONTCARE;
+	cfi.FontWeight = FW_NORMAL;
+
+	wcscpy_s(cfi.FaceName, L"Consolas");
+	if (!SetCurrentConsoleFontEx(outConsoleHandle, false, &cfi))
+	{
+		return error(L"SetCurrentConsoleFontEx error");
+	}
+
+	//      
+	CONSOLE_SCREEN_BUFFER_INFO csbi;
+	if (!GetConsoleScreenBufferInfo(outConsoleHandle, &csbi))
+	{
+		return error(L"GetConsoleScreenBufferInfo error");
+	}
+	if (consoleHeight > csbi.dwMaximumWindowSize.Y)
+	{
+		return error(L"Screen height / font height error");
+	}
+	if (consoleWidth > csbi.dwMaximumWindowSize.X)
+	{
+		return error(L"Screen width / font width error");
+	}
+
+	//    
+	rectWindow = { 0, 0, (int16_t)consoleWidth - 1, (int16_t)consoleHeight - 1 };
+	if (!SetConsoleWindowInfo(outConsoleHandle, TRUE, &rectWindow))
+	{
+		return error(L"SetConsoleWindowInfo error");
+	}
+
+	//    
+	if (!SetConsoleMode(inConsoleHandle, ENABLE_EXTENDED_FLAGS | ENABLE_WINDOW_INPUT | ENABLE_MOUSE_INPUT))
+	{
+		return error(L"SetConsoleMode error");
+	}
+	frameDiff.reset(consoleWidth, consoleHeight);
+	//   -    
+	dirtyRuns.reserve(consoleHeight * ((consoleWidth + 1) / 2));
+	return 0;
+}
+
+int16_t ConsolePresenter::error(const wchar_t* msg)
+{
+	wchar_t buf[256];
+
+	setConsoleDefault();
+	FormatMessage(FORMAT_MESSAGE_FROM_SYSTEM, NULL, GetLastError(), MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), buf, 256, NULL);
+	SetConsoleActiveScreenBuffer(orgConsoleHandle);
+	wprintf(L"ERROR: %s\n\t%s\n", msg, buf);
+	return 1;
+}
+
+void ConsolePresenter::setConsoleDefault()
+{
+	CONSOLE_FONT_INFOEX cfi;
+	cfi.cbSize = sizeof(cfi);
+	cfi.nFont = 0;
+	cfi.dwFontSize.X = 10;
+	cfi.dwFontSize.Y = 15;
+	cfi.FontFamily = FF_DONTCARE;
+	cfi.FontWeight = FW_NORMAL;
+
+	wcscpy_s(cfi.FaceName, L"Lucida Console");
+	SetCurrentConsoleFontEx(outConsoleHandle, false, &cfi);
+
+	//   screen buffer
+	COORD coord = { 150, 50 };
+	SetConsoleScreenBufferSize(outConsoleHandle, coord);
+	SetConsoleActiveScreenBuffer(outConsoleHandle);
+
+	//    
+	rectWindow = { 0, 0, 145, 45 };
+	SetConsoleWindowInfo(outConsoleHandle, TRUE, &rectWindow);
+}
+
+void ConsolePresenter::pollInput(int16_t* keyStates, bool* mouseStates, int16_t& mouseX, int16_t& mouseY, bool& inFocus)
+{
+	//   
+	for (int16_t i = 0; i < 256; i++)
+	{
+		keyStates[i] = GetAsyncKeyState(i);
+	}
+
+	//   
+	INPUT_RECORD inBuf[32];
+	DWORD events = 0;
+	GetNumberOfConsoleInputEvents(inConsoleHandle, &events);
+	if (events > 0)
+	{
+		ReadConsoleInput(inConsoleHandle, inBuf, events, &events);
+	}
+
+	//  
+	for (DWORD i = 0; i < events; i++)
+	{
+		switch (inBuf[i].EventType)
+		{
+			case FOCUS_EVENT:
+			{
+				inFocus = inBuf[i].Event.FocusEvent.bSetFocus;
+			}
+			break;
+			case MOUSE_EVENT:
+			{
+				switch (inBuf[i].Event.MouseEvent.dwEventFlags)
+				{
+					case MOUSE_MOVED:
+					{
+						mouseX = inBuf[i].Event.MouseEvent.dwMousePosition.X;
+						mouseY = inBuf[i].Event.MouseEvent.dwMousePosition.Y;
+					}
+					break;
+					case 0:
+					{
+						for (int16_t m = 0; m < 5; m++)
+						{
+							mouseStates[m] = (inBuf[i].Event.MouseEvent.dwButtonState & (1 << m)) > 0;
+						}
+
+					}
+					break;
+					default:
+						break;
+				}
+			}
+			break;
+			default:
+				break;
+		}
+	}
+}
+
+void ConsolePresenter::present(const CHAR_INFO* buffer, int16_t width, int16_t height)
+{
+	size_t changed = frameDiff.compute(buffer, dirtyRuns, 8);
+
+	if (changed == 0)
+	{
+		return;
+	}
+
+	//        
+	if (changed * 2 > static_cast<size_t>(width * height))
+	{
+		WriteConsoleOutput(outConsoleHandle, buffer, { width, height }, { 0,0 }, &rectWindow);
+		return;
+	}
+	for (auto& run : dirtyRuns)
+	{
+		SMALL_RECT rect = { run.x1, run.y, run.x2, run.y };
+		WriteConsoleOutput(outConsoleHandle, buffer, { width, height }, { run.x1, run.y }, &rect);
+	}
+}
+
+void ConsolePresenter::setTitle(const wstring& title)
+{
+	SetConsoleTitle(title.c_str());
+}
+
+bool ConsolePresenter::waitForInput(uint32_t timeoutMs)
+{
+	return WaitForSingleObject(inConsoleHandle, timeoutMs) == WAIT_OBJECT_0;
+}
@@ -0,0 +1,32 @@
+#ifndef _CONSOLE_PRESENTER_H_
+#define _CONSOLE_PRESENTER_H_
+
+#include "Presenter.h"
+
+//    Win32
+class ConsolePresenter : public Presenter
+{
+private:
+	int16_t consoleWidth, consoleHeight;
+	SMALL_RECT rectWindow;
+	HANDLE outConsoleHandle;
+	HANDLE inConsoleHandle;
+	HANDLE orgConsoleHandle;
+	FrameDiff frameDiff;
+	vector<DirtyRun> dirtyRuns;
+
+	void setConsoleDefault();
+
+public:
+	ConsolePresenter();
+	~ConsolePresenter();
+
+	virtual int16_t create(int16_t width, int16_t height, int16_t fontW, int16_t fontH, const wstring& title) override;
+	virtual void pollInput(int16_t* keyStates, bool* mouseStates, int16_t& mouseX, int16_t& mouseY, bool& inFocus) override;
+	virtual void present(const CHAR_INFO* buffer, int16_t width, int16_t height) override;
+	virtual void setTitle(const wstring& title) override;
+	virtual int16_t error(const wchar_t* msg) override;
+	virtual bool waitForInput(uint32_t timeoutMs) override;
+};
+
+#endif
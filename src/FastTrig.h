@@ -0,0 +1,51 @@
+#ifndef _FAST_TRIG_H_
+#define _FAST_TRIG_H_
+
+#include <cmath>
+#include <cstdint>
+
+// GEOMETRY_FAST_TRIG  sinf/cosf    ,   5e-6
+constexpr int32_t TRIG_TABLE_SIZE = 1024;
+
+#ifdef GEOMETRY_FAST_TRIG
+struct SinTable
+{
+	float values[TRIG_TABLE_SIZE + 1];
+
+	SinTable()
+	{
+		for (int32_t i = 0; i <= TRIG_TABLE_SIZE; i++)
+		{
+			values[i] = static_cast<float>(sin(6.283185307179586 * i / TRIG_TABLE_SIZE));
+		}
+	}
+};
+
+inline const SinTable& getSinTable()
+{
+	static const SinTable table;
+	return table;
+}
+#endif
+
+//        
+inline void fastSinCos(float angle, float& s, float& c)
+{
+#ifdef GEOMETRY_FAST_TRIG
+	const float* values = getSinTable().values;
+	float t = angle * (TRIG_TABLE_SIZE / 6.283185307f);
+	float base = floorf(t);
+	float frac = t - base;
+
+	//  -        
+	int32_t i = static_cast<int32_t>(static_cast<int64_t>(base) & (TRIG_TABLE_SIZE - 1));
+	int32_t j = (i + TRIG_TABLE_SIZE / 4) & (TRIG_TABLE_SIZE - 1);
+	s = values[i] + (values[i + 1] - values[i]) * frac;
+	c = values[j] + (values[j + 1] - values[j]) * frac;
+#else
+	s = sinf(angle);
+	c = cosf(angle);
+#endif
+}
+
+#endif
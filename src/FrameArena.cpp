@@ -0,0 +1,62 @@
+#include "FrameArena.h"
+#include <algorithm>
+
+FrameArena::FrameArena(size_t initialSize)
+{
+	offset = 0;
+	addBlock(initialSize);
+}
+
+FrameArena::~FrameArena()
+{
+	for (auto& block : blocks)
+	{
+		delete[] block.data;
+	}
+}
+
+void FrameArena::addBlock(size_t size)
+{
+	blocks.push_back({ new uint8_t[size], size });
+	offset = 0;
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+	//    operator new[],   
+	size_t start = (offset + alignment - 1) & ~(alignment - 1);
+	if (start + size > blocks.back().size)
+	{
+		//      ,    
+		addBlock(max(size + alignment, 2 * blocks.back().size));
+		start = 0;
+	}
+	offset = start + size;
+	return blocks.back().data + start;
+}
+
+void FrameArena::reset()
+{
+	//      ,     
+	if (blocks.size() > 1)
+	{
+		size_t capacity = getCapacity();
+		for (auto& block : blocks)
+		{
+			delete[] block.data;
+		}
+		blocks.clear();
+		addBlock(capacity);
+	}
+	offset = 0;
+}
+
+size_t FrameArena::getCapacity()
+{
+	size_t capacity = 0;
+	for (auto& block : blocks)
+	{
+		capacity += block.size;
+	}
+	return capacity;
+}
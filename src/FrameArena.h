@@ -0,0 +1,73 @@
+#ifndef _FRAME_ARENA_H_
+#define _FRAME_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+//      ,     
+class FrameArena
+{
+private:
+	struct Block
+	{
+		uint8_t* data;
+		size_t size;
+	};
+
+	vector<Block> blocks;
+	size_t offset;
+
+	void addBlock(size_t size);
+
+public:
+	FrameArena(size_t initialSize = 1 << 20);
+	~FrameArena();
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	void* allocate(size_t size, size_t alignment);
+	void reset();
+
+	size_t getCapacity();
+};
+
+//       
+template <class T>
+class ArenaAllocator
+{
+public:
+	typedef T value_type;
+
+	FrameArena* arena;
+
+	ArenaAllocator(FrameArena& arena) : arena(&arena) {}
+	template <class U>
+	ArenaAllocator(const ArenaAllocator<U>& obj) : arena(obj.arena) {}
+
+	T* allocate(size_t count)
+	{
+		return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+	}
+	//      
+	void deallocate(T*, size_t) {}
+
+	template <class U>
+	bool operator==(const ArenaAllocator<U>& obj) const
+	{
+		return arena == obj.arena;
+	}
+	template <class U>
+	bool operator!=(const ArenaAllocator<U>& obj) const
+	{
+		return arena != obj.arena;
+	}
+};
+
+template <class T>
+using FrameVector = vector<T, ArenaAllocator<T>>;
+
+#endif
@@ -0,0 +1,123 @@
+#include "FramePipeline.h"
+#include <algorithm>
+#include <chrono>
+
+FramePipeline::FramePipeline()
+{
+	presenter = nullptr;
+	width = height = 0;
+	back = 0;
+	published = 1;
+	ready = 1;
+	open = true;
+	presentTime = 0;
+	stopping = false;
+	lossless = false;
+}
+
+FramePipeline::~FramePipeline()
+{
+	stop();
+}
+
+void FramePipeline::start(Presenter* presenter, int16_t width, int16_t height)
+{
+	stop();
+	this->presenter = presenter;
+	this->width = width;
+	this->height = height;
+
+	for (int16_t i = 0; i < 3; i++)
+	{
+		buffers[i].assign(static_cast<size_t>(width) * height, CHAR_INFO{});
+		titles[i].reserve(256);
+	}
+	//  0   , 1  , 2   
+	back = 0;
+	published = 1;
+	ready = 1;
+	open = presenter->isOpen();
+	stopping = false;
+	lossless = presenter->isLossless();
+	presentThread = thread(&FramePipeline::presentLoop, this);
+}
+
+void FramePipeline::stop()
+{
+	if (!presentThread.joinable())
+	{
+		return;
+	}
+	{
+		lock_guard<mutex> lock(wakeMutex);
+		stopping = true;
+	}
+	wakeCondition.notify_one();
+	presentThread.join();
+}
+
+void FramePipeline::restoreBackBuffer()
+{
+	//      ,    
+	copy(buffers[published].begin(), buffers[published].end(), buffers[back].begin());
+}
+
+CHAR_INFO* FramePipeline::publish(const wchar_t* title)
+{
+	//    ,     
+	if (lossless)
+	{
+		unique_lock<mutex> lock(wakeMutex);
+		consumedCondition.wait(lock, [&]() { return !(ready.load() & FRESH_FLAG); });
+	}
+
+	//     
+	titles[back].assign(title);
+	published = back;
+	back = ready.exchange(static_cast<uint8_t>(back | FRESH_FLAG)) & INDEX_MASK;
+
+	//     ,     
+	{
+		lock_guard<mutex> lock(wakeMutex);
+	}
+	wakeCondition.notify_one();
+	return buffers[back].data();
+}
+
+void FramePipeline::presentLoop()
+{
+	uint8_t front = 2;
+
+	while (true)
+	{
+		{
+			unique_lock<mutex> lock(wakeMutex);
+			wakeCondition.wait(lock, [&]() { return stopping || (ready.load() & FRESH_FLAG); });
+			//     ,   
+			if (stopping && !(ready.load() & FRESH_FLAG))
+			{
+				return;
+			}
+		}
+
+		//    ,  
+		front = ready.exchange(front) & INDEX_MASK;
+		if (lossless)
+		{
+			{
+				lock_guard<mutex> lock(wakeMutex);
+			}
+			consumedCondition.notify_one();
+		}
+		if (!open)
+		{
+			continue;
+		}
+
+		auto start = chrono::steady_clock::now();
+		presenter->setTitle(titles[front]);
+		presenter->present(buffers[front].data(), width, height);
+		presentTime = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+		open = presenter->isOpen();
+	}
+}
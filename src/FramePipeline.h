@@ -0,0 +1,65 @@
+#ifndef _FRAME_PIPELINE_H_
+#define _FRAME_PIPELINE_H_
+
+#include "Presenter.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//   :     ,    
+class FramePipeline
+{
+private:
+	//   -  ,  -   
+	static const uint8_t INDEX_MASK = 0x03;
+	static const uint8_t FRESH_FLAG = 0x04;
+
+	vector<CHAR_INFO> buffers[3];
+	wstring titles[3];
+	Presenter* presenter;
+	int16_t width, height;
+	uint8_t back, published;
+	atomic<uint8_t> ready;
+	atomic<bool> open;
+	atomic<int64_t> presentTime;
+	thread presentThread;
+	mutex wakeMutex;
+	condition_variable wakeCondition;
+	condition_variable consumedCondition;
+	bool stopping;
+	bool lossless;
+
+	void presentLoop();
+
+public:
+	FramePipeline();
+	~FramePipeline();
+
+	void start(Presenter* presenter, int16_t width, int16_t height);
+	void stop();
+
+	CHAR_INFO* getBackBuffer()
+	{
+		return buffers[back].data();
+	}
+	void restoreBackBuffer();
+	CHAR_INFO* publish(const wchar_t* title);
+
+	bool isOpen()
+	{
+		return open.load();
+	}
+	//   , 
+	int64_t getPresentTime()
+	{
+		return presentTime.load();
+	}
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include "FrameScheduler.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+FrameScheduler::FrameScheduler(float targetFps, float fixedStep, size_t capacity)
+{
+	this->targetFps = targetFps;
+	this->fixedStep = fixedStep;
+	spinTime = 0.002f;
+	maxSteps = 8;
+	frameTime = 0.0f;
+	accumulator = 0.0f;
+	variableStepPending = false;
+	paced = false;
+	frameStart = previousStart = chrono::steady_clock::now();
+	jitterSamples.assign(max<size_t>(capacity, 1), 0.0f);
+	nextSample = 0;
+	sampleCount = 0;
+}
+
+float FrameScheduler::beginFrame()
+{
+	previousStart = frameStart;
+	frameStart = chrono::steady_clock::now();
+	frameTime = chrono::duration<float>(frameStart - previousStart).count();
+
+	//       ,  
+	if (paced && targetFps > 0.0f)
+	{
+		jitterSamples[nextSample] = fabsf(frameTime - 1.0f / targetFps) * 1000.0f;
+		nextSample = (nextSample + 1) % jitterSamples.size();
+		sampleCount = min(sampleCount + 1, jitterSamples.size());
+	}
+	paced = false;
+
+	//        
+	frameTime = min(frameTime, 0.25f);
+	if (fixedStep > 0.0f)
+	{
+		accumulator = min(accumulator + frameTime, fixedStep * maxSteps);
+	}
+	else
+	{
+		variableStepPending = true;
+	}
+	return frameTime;
+}
+
+//       :      
+void FrameScheduler::resume()
+{
+	frameStart = chrono::steady_clock::now();
+	accumulator = 0.0f;
+	paced = false;
+}
+
+bool FrameScheduler::nextStep(float& step)
+{
+	if (fixedStep <= 0.0f)
+	{
+		step = frameTime;
+		bool pending = variableStepPending;
+		variableStepPending = false;
+		return pending;
+	}
+	if (accumulator >= fixedStep)
+	{
+		accumulator -= fixedStep;
+		step = fixedStep;
+		return true;
+	}
+	return false;
+}
+
+float FrameScheduler::getAlpha()
+{
+	return (fixedStep > 0.0f) ? accumulator / fixedStep : 1.0f;
+}
+
+void FrameScheduler::waitForNextFrame()
+{
+	if (targetFps <= 0.0f)
+	{
+		return;
+	}
+	paced = true;
+
+	//   ,   :      
+	auto deadline = frameStart + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<float>(1.0f / targetFps));
+	auto wakeUp = deadline - chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<float>(spinTime));
+	if (chrono::steady_clock::now() < wakeUp)
+	{
+		this_thread::sleep_until(wakeUp);
+	}
+	while (chrono::steady_clock::now() < deadline)
+	{
+		this_thread::yield();
+	}
+}
+
+FrameScheduler::JitterStats FrameScheduler::getJitter()
+{
+	JitterStats stats = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	if (sampleCount == 0)
+	{
+		return stats;
+	}
+
+	vector<float> sorted(jitterSamples.begin(), jitterSamples.begin() + sampleCount);
+	sort(sorted.begin(), sorted.end());
+
+	float sum = 0.0f;
+	for (float value : sorted)
+	{
+		sum += value;
+	}
+	stats.mean = sum / sampleCount;
+	stats.p50 = sorted[(sampleCount - 1) * 50 / 100];
+	stats.p99 = sorted[(sampleCount - 1) * 99 / 100];
+	stats.max = sorted.back();
+	return stats;
+}
@@ -0,0 +1,56 @@
+#ifndef _FRAME_SCHEDULER_H_
+#define _FRAME_SCHEDULER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+//         
+class FrameScheduler
+{
+public:
+	struct JitterStats
+	{
+		float mean, p50, p99, max;
+	};
+
+private:
+	float targetFps;
+	float fixedStep;
+	float spinTime;
+	uint32_t maxSteps;
+	float frameTime;
+	float accumulator;
+	bool variableStepPending;
+	bool paced;
+	chrono::steady_clock::time_point frameStart;
+	chrono::steady_clock::time_point previousStart;
+	vector<float> jitterSamples;
+	size_t nextSample;
+	size_t sampleCount;
+
+public:
+	FrameScheduler(float targetFps = 0.0f, float fixedStep = 1.0f / 60.0f, size_t capacity = 256);
+
+	void setTargetFps(float fps)
+	{
+		targetFps = fps;
+	}
+	//  :        
+	void setFixedStep(float step)
+	{
+		fixedStep = step;
+		accumulator = 0.0f;
+	}
+
+	float beginFrame();
+	void resume();
+	bool nextStep(float& step);
+	float getAlpha();
+	void waitForNextFrame();
+	JitterStats getJitter();
+};
+
+#endif
@@ -1,15 +1,28 @@
 #include "Geometry.h"
+#include "MeshSimplifier.h"
+#include <cstdio>
+#include <unordered_map>
 
 Geometry::Geometry()
 {
 	consoleWidth = 120;
 	consoleHeight = 60;
 
-	outConsoleHandle = GetStdHandle(STD_OUTPUT_HANDLE);
-	inConsoleHandle = GetStdHandle(STD_INPUT_HANDLE);
-
+	presenter = nullptr;
 	console = nullptr;
-	rectWindow = { 0 };
+	renderMode = RENDER_PAINTER;
+	subcellMode = SUBCELL_OFF;
+	subcellColumns = subcellRows = 1;
+	showProfiler = false;
+	shadowWidth = shadowHeight = 0;
+	shadowMinX = shadowMinY = 0;
+	shadowMaxX = shadowMaxY = -1;
+	cullBackfaces = true;
+	redrawRequested = true;
+	frameAllocations = 0;
+	frameLimit = 0;
+	frameCount = 0;
+	trianglePoints.resize(3);
 
 	memset(newKeyStates, 0, 256 * sizeof(short));
 	memset(oldKeyStates, 0, 256 * sizeof(short));
@@ -26,234 +39,296 @@ Geometry::Geometry()
 
 Geometry::~Geometry()
 {
-	SetConsoleActiveScreenBuffer(orgConsoleHandle);
-	delete[] console;
+	pipeline.stop();
+	delete presenter;
+}
+
+void Geometry::setPresenter(Presenter* newPresenter)
+{
+	delete presenter;
+	presenter = newPresenter;
 }
 
 int16_t Geometry::constructConsole(int16_t width, int16_t height, int16_t fontW, int16_t fontH, wstring consoleName)
 {
 	appName = consoleName;
 
-	if (outConsoleHandle == INVALID_HANDLE_VALUE)
+	if (!presenter)
 	{
-		return error(L"Invalid handle value error");
+		presenter = createDefaultPresenter();
 	}
 	consoleWidth = width;
 	consoleHeight = height;
 
-	rectWindow = { 0, 0, 1, 1 };
-	SetConsoleWindowInfo(outConsoleHandle, TRUE, &rectWindow);
-
-	//   screen buffer
-	COORD coord = { (int16_t)consoleWidth, (int16_t)consoleHeight };
-	if (!SetConsoleScreenBufferSize(outConsoleHandle, coord))
-	{
-		error(L"SetConsoleScreenBufferSize error");
-	}
-	if (!SetConsoleActiveScreenBuffer(outConsoleHandle))
+	if (presenter->create(width, height, fontW, fontH, consoleName))
 	{
-		return error(L"SetConsoleActiveScreenBuffer error");
+		return 1;
 	}
+	pipeline.start(presenter, consoleWidth, consoleHeight);
+	console = pipeline.getBackBuffer();
+	fillStack.reserve(consoleWidth + consoleHeight);
+	depthBuffer.assign(consoleWidth * consoleHeight, INFINITY);
+	return 0;
+}
 
-	//     screen buffer
-	CONSOLE_FONT_INFOEX cfi;
-	cfi.cbSize = sizeof(cfi);
-	cfi.nFont = 0;
-	cfi.dwFontSize.X = fontW;
-	cfi.dwFontSize.Y = fontH;
-	cfi.FontFamily = FF_DONTCARE;
-	cfi.FontWeight = FW_NORMAL;
-	
-	wcscpy_s(cfi.FaceName, L"Consolas");
-	if (!SetCurrentConsoleFontEx(outConsoleHandle, false, &cfi))
-	{
-		return error(L"SetCurrentConsoleFontEx error");
-	}
+int16_t Geometry::error(const wchar_t* msg)
+{
+	return presenter->error(msg);
+}
 
-	//      
-	CONSOLE_SCREEN_BUFFER_INFO csbi;
-	if (!GetConsoleScreenBufferInfo(outConsoleHandle, &csbi))
-	{
-		return error(L"GetConsoleScreenBufferInfo error");
-	}
-	if (consoleHeight > csbi.dwMaximumWindowSize.Y)
-	{
-		return error(L"Screen height / font height error");
-	}
-	if (consoleWidth > csbi.dwMaximumWindowSize.X)
+void Geometry::run()
+{
+	userCreateHandle();
+
+	bool isExit = false;
+
+	while (!isExit)
 	{
-		return error(L"Screen width / font width error");
+		//    
+		float fElapsedTime = scheduler.beginFrame();
+		auto frameStart = chrono::steady_clock::now();
+		uint64_t allocationsStart = AllocationCounter::getAllocations();
+
+		{
+			PROFILE_SCOPE(profiler, STAGE_INPUT);
+			updateInput();
+		}
+
+		//    
+		if (keys['P'].bPressed)
+		{
+			showProfiler = !showProfiler;
+			profiler.setEnabled(profiler.isEnabled() || showProfiler);
+			invalidate();
+		}
+
+		//   : , , 
+		if (keys['H'].bPressed)
+		{
+			setSubcellMode(static_cast<SUBCELL_MODE>((subcellMode + 1) % (SUBCELL_BRAILLE + 1)));
+		}
+
+		//    ,    
+		float fFixedStep;
+		while (scheduler.nextStep(fFixedStep))
+		{
+			userFixedUpdateHandle(fFixedStep);
+		}
+
+		//      ,      
+		beginSubcells();
+		bool frameChanged = userUpdateHandle(fElapsedTime);
+		endSubcells(frameChanged);
+		if (!frameChanged)
+		{
+			pipeline.restoreBackBuffer();
+		}
+		if (showProfiler)
+		{
+			drawProfilerOverlay();
+		}
+
+		//    ,     
+		wchar_t s[256];
+		swprintf(s, 256, L"%ls - FPS: %3.2f", appName.c_str(), 1.0f / fElapsedTime);
+		console = pipeline.publish(s);
+		frameArena.reset();
+		frameAllocations = AllocationCounter::getAllocations() - allocationsStart;
+
+		profiler.addTime(STAGE_PRESENT, pipeline.getPresentTime());
+		profiler.addTime(STAGE_FRAME, chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - frameStart).count());
+		profiler.endFrame();
+		frameCount++;
+		isExit = !pipeline.isOpen() || (frameLimit > 0 && frameCount >= frameLimit);
+
+		//         .       
+		if (!frameChanged && !showProfiler && !isExit && frameLimit == 0)
+		{
+			presenter->waitForInput(IDLE_WAIT_MS);
+			scheduler.resume();
+		}
+		else
+		{
+			scheduler.waitForNextFrame();
+		}
 	}
+	pipeline.stop();
+}
 
-	//    
-	rectWindow = { 0, 0, (int16_t)consoleWidth - 1, (int16_t)consoleHeight - 1 };
-	if (!SetConsoleWindowInfo(outConsoleHandle, TRUE, &rectWindow))
+bool Geometry::updateInput()
+{
+	bool keyChanged = false;
+
+	//     
+	presenter->pollInput(newKeyStates, newMouseStates, mouseX, mouseY, consoleInFocus);
+
+	for (int16_t i = 0; i < 256; i++)
 	{
-		return error(L"SetConsoleWindowInfo error");
+		keys[i].bPressed = false;
+		keys[i].bReleased = false;
+		if (newKeyStates[i] != oldKeyStates[i])
+		{
+			if (newKeyStates[i] & 0x8000)
+			{
+				keys[i].bPressed = !keys[i].bHeld;
+				keys[i].bHeld = true;
+			}
+			else
+			{
+				keys[i].bReleased = true;
+				keys[i].bHeld = false;
+			}
+			keyChanged = true;
+		}
+		oldKeyStates[i] = newKeyStates[i];
 	}
 
-	//    		
-	if (!SetConsoleMode(inConsoleHandle, ENABLE_EXTENDED_FLAGS | ENABLE_WINDOW_INPUT | ENABLE_MOUSE_INPUT))
+	for (int16_t m = 0; m < 5; m++)
 	{
-		return error(L"SetConsoleMode error");
+		mouse[m].bPressed = false;
+		mouse[m].bReleased = false;
+		if (newMouseStates[m] != oldMouseStates[m])
+		{
+			if (newMouseStates[m])
+			{
+				mouse[m].bPressed = true;
+				mouse[m].bHeld = true;
+			}
+			else
+			{
+				mouse[m].bReleased = true;
+				mouse[m].bHeld = false;
+			}
+		}
+		oldMouseStates[m] = newMouseStates[m];
 	}
-	console = new CHAR_INFO[consoleWidth * consoleHeight];
-	memset(console, 0, sizeof(CHAR_INFO) * consoleWidth * consoleHeight);
-	return 0;
+	return keyChanged;
 }
 
-int16_t Geometry::error(const wchar_t* msg)
+void Geometry::setSubcellMode(SUBCELL_MODE mode)
 {
-	wchar_t buf[256];
-
-	setConsoleDefault();
-	FormatMessage(FORMAT_MESSAGE_FROM_SYSTEM, NULL, GetLastError(), MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT), buf, 256, NULL);
-	SetConsoleActiveScreenBuffer(orgConsoleHandle);
-	wprintf(L"ERROR: %s\n\t%s\n", msg, buf);
-	return 1;
+	subcellMode = mode;
+	subcellColumns = (mode == SUBCELL_BRAILLE) ? 2 : 1;
+	subcellRows = (mode == SUBCELL_BRAILLE) ? 4 : ((mode == SUBCELL_HALF_BLOCK) ? 2 : 1);
+	invalidate();
 }
 
-void Geometry::setConsoleDefault()
+void Geometry::beginSubcells()
 {
-	CONSOLE_FONT_INFOEX cfi;
-	cfi.cbSize = sizeof(cfi);
-	cfi.nFont = 0;
-	cfi.dwFontSize.X = 10;
-	cfi.dwFontSize.Y = 15;
-	cfi.FontFamily = FF_DONTCARE;
-	cfi.FontWeight = FW_NORMAL;
-
-	wcscpy_s(cfi.FaceName, L"Lucida Console");
-	SetCurrentConsoleFontEx(outConsoleHandle, false, &cfi);
-
-	//   screen buffer
-	COORD coord = { 150, 50 };
-	SetConsoleScreenBufferSize(outConsoleHandle, coord);
-	SetConsoleActiveScreenBuffer(outConsoleHandle);
+	if (subcellMode == SUBCELL_OFF)
+	{
+		return;
+	}
 
-	//    
-	rectWindow = { 0, 0, 145, 45 };
-	SetConsoleWindowInfo(outConsoleHandle, TRUE, &rectWindow);
+	//       ,      
+	consoleWidth *= subcellColumns;
+	consoleHeight *= subcellRows;
+	subcellBuffer.resize(static_cast<size_t>(consoleWidth) * consoleHeight);
+	depthBuffer.resize(static_cast<size_t>(consoleWidth) * consoleHeight, INFINITY);
+	console = subcellBuffer.data();
 }
 
-void Geometry::run()
+void Geometry::endSubcells(bool frameChanged)
 {
-	auto tp1 = chrono::system_clock::now();
-	auto tp2 = chrono::system_clock::now();
-
-	userCreateHandle();
+	if (subcellMode == SUBCELL_OFF)
+	{
+		return;
+	}
 
-	bool isExit = false;
-	bool ifKeyPressed = true;
+	consoleWidth /= subcellColumns;
+	consoleHeight /= subcellRows;
+	depthBuffer.resize(static_cast<size_t>(consoleWidth) * consoleHeight);
+	console = pipeline.getBackBuffer();
+	if (frameChanged)
+	{
+		PROFILE_SCOPE(profiler, STAGE_FILL);
+		resolveSubcells();
+	}
+}
 
-	while (!isExit)
+uint16_t Geometry::getVisibleColour(const CHAR_INFO& cell)
+{
+	//      ,   -  
+	if (cell.Char.UnicodeChar == L' ' || cell.Char.UnicodeChar == PIXEL_QUARTER)
 	{
-		// 
-		tp2 = chrono::system_clock::now();
-		chrono::duration<float> elapsedTime = tp2 - tp1;
-		tp1 = tp2;
-		float fElapsedTime = elapsedTime.count();
+		return (cell.Attributes >> 4) & 0x0F;
+	}
+	return cell.Attributes & 0x0F;
+}
 
-		//   
-		for (int16_t i = 0; i < 256; i++)
-		{
-			newKeyStates[i] = GetAsyncKeyState(i);
-			keys[i].bPressed = false;
-			keys[i].bReleased = false;
-			if (newKeyStates[i] != oldKeyStates[i])
-			{
-				if (newKeyStates[i] & 0x8000)
-				{
-					keys[i].bPressed = !keys[i].bHeld;
-					keys[i].bHeld = true;
-				}
-				else
-				{
-					keys[i].bReleased = true;
-					keys[i].bHeld = false;
-				}
-				ifKeyPressed = true;
-			}
-			oldKeyStates[i] = newKeyStates[i];
-		}
+void Geometry::resolveSubcells()
+{
+	//          
+	static const uint8_t brailleDots[4][2] = { { 0x01, 0x08 }, { 0x02, 0x10 }, { 0x04, 0x20 }, { 0x40, 0x80 } };
+	size_t stride = static_cast<size_t>(consoleWidth) * subcellColumns;
 
-		//   
-		INPUT_RECORD inBuf[32];
-		DWORD events = 0;
-		GetNumberOfConsoleInputEvents(inConsoleHandle, &events);
-		if (events > 0)
+	for (int16_t y = 0; y < consoleHeight; y++)
+	{
+		for (int16_t x = 0; x < consoleWidth; x++)
 		{
-			ReadConsoleInput(inConsoleHandle, inBuf, events, &events);
-		}
+			const CHAR_INFO* block = &subcellBuffer[y * subcellRows * stride + x * subcellColumns];
+			CHAR_INFO& cell = console[y * consoleWidth + x];
 
-		//  
-		for (DWORD i = 0; i < events; i++)
-		{
-			switch (inBuf[i].EventType)
+			//     ,   
+			bool uniform = true;
+			for (int16_t r = 0; r < subcellRows && uniform; r++)
 			{
-				case FOCUS_EVENT:
-				{
-					consoleInFocus = inBuf[i].Event.FocusEvent.bSetFocus;
-				}
-				break;
-				case MOUSE_EVENT:
+				for (int16_t c = 0; c < subcellColumns; c++)
 				{
-					switch (inBuf[i].Event.MouseEvent.dwEventFlags)
+					const CHAR_INFO& pixel = block[r * stride + c];
+					if (pixel.Char.UnicodeChar != block[0].Char.UnicodeChar || pixel.Attributes != block[0].Attributes)
 					{
-						case MOUSE_MOVED:
-						{
-							mouseX = inBuf[i].Event.MouseEvent.dwMousePosition.X;
-							mouseY = inBuf[i].Event.MouseEvent.dwMousePosition.Y;
-						}
+						uniform = false;
 						break;
-						case 0:
-						{
-							for (int16_t m = 0; m < 5; m++)
-							{
-								newMouseStates[m] = (inBuf[i].Event.MouseEvent.dwButtonState & (1 << m)) > 0;
-							}
-
-						}
-						break;
-						default:
-							break;
 					}
 				}
-				break;
-				default:
-					break;
-				}
+			}
+			if (uniform)
+			{
+				cell = block[0];
+				continue;
 			}
 
-		for (int16_t m = 0; m < 5; m++)
-		{
-			mouse[m].bPressed = false;
-			mouse[m].bReleased = false;
-			if (newMouseStates[m] != oldMouseStates[m])
+			if (subcellMode == SUBCELL_HALF_BLOCK)
+			{
+				cell.Char.UnicodeChar = 0x2580;
+				cell.Attributes = getVisibleColour(block[0]) | (getVisibleColour(block[stride]) << 4);
+				continue;
+			}
+
+			//  -    ,  -   
+			uint16_t colours[4][2];
+			uint8_t counts[16] = { 0 };
+			for (int16_t r = 0; r < 4; r++)
 			{
-				if (newMouseStates[m])
+				for (int16_t c = 0; c < 2; c++)
 				{
-					mouse[m].bPressed = true;
-					mouse[m].bHeld = true;
+					colours[r][c] = getVisibleColour(block[r * stride + c]);
+					counts[colours[r][c]]++;
 				}
-				else
+			}
+			uint16_t background = 0, foreground = 0;
+			for (uint16_t i = 1; i < 16; i++)
+			{
+				background = (counts[i] > counts[background]) ? i : background;
+			}
+			counts[background] = 0;
+			for (uint16_t i = 1; i < 16; i++)
+			{
+				foreground = (counts[i] > counts[foreground]) ? i : foreground;
+			}
+
+			uint8_t dots = 0;
+			for (int16_t r = 0; r < 4; r++)
+			{
+				for (int16_t c = 0; c < 2; c++)
 				{
-					mouse[m].bReleased = true;
-					mouse[m].bHeld = false;
+					dots |= (colours[r][c] != background) ? brailleDots[r][c] : 0;
 				}
 			}
-			oldMouseStates[m] = newMouseStates[m];
+			cell.Char.UnicodeChar = 0x2800 + dots;
+			cell.Attributes = foreground | (background << 4);
 		}
-
-		if (ifKeyPressed)
-		{
-			userUpdateHandle(fElapsedTime);
-		}
-
-		wchar_t s[256];
-		swprintf_s(s, 256, L"%s - FPS: %3.2f", appName.c_str(), 1.0f / fElapsedTime);
-		SetConsoleTitle(s);
-		WriteConsoleOutput(outConsoleHandle, console, { consoleWidth, consoleHeight }, { 0,0 }, &rectWindow);
 	}
 }
 
@@ -281,6 +356,37 @@ void Geometry::simpleDraw(int16_t x, int16_t y, int16_t sym, int16_t col)
 	}
 }
 
+void Geometry::drawString(int16_t x, int16_t y, const string& text, int16_t col)
+{
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		simpleDraw(x + (int16_t)i, y, text[i], col);
+	}
+}
+
+void Geometry::drawProfilerOverlay()
+{
+	char line[64];
+
+	drawString(1, 1, "stage        p50 ms   p99 ms", FG_WHITE | BG_BLACK);
+	for (int16_t i = 0; i < STAGE_COUNT; i++)
+	{
+		PROFILE_STAGE stage = static_cast<PROFILE_STAGE>(i);
+		Profiler::StageStats stats = profiler.getStats(stage);
+		snprintf(line, sizeof(line), "%-10s %8.3f %8.3f", Profiler::stageName(stage), stats.p50, stats.p99);
+		drawString(1, 2 + i, line, FG_WHITE | BG_BLACK);
+	}
+
+	FrameScheduler::JitterStats jitter = scheduler.getJitter();
+	snprintf(line, sizeof(line), "%-10s %8.3f %8.3f", "jitter", jitter.p50, jitter.p99);
+	drawString(1, 2 + STAGE_COUNT, line, FG_WHITE | BG_BLACK);
+
+#ifdef KGK_COUNT_ALLOCATIONS
+	snprintf(line, sizeof(line), "%-10s %8llu", "allocs", static_cast<unsigned long long>(frameAllocations));
+	drawString(1, 3 + STAGE_COUNT, line, FG_WHITE | BG_BLACK);
+#endif
+}
+
 void Geometry::drawBresenhamLine(int16_t x1, int16_t y1, int16_t x2, int16_t y2, int16_t sym, int16_t col)
 {
 	int16_t x, y;
@@ -349,12 +455,20 @@ void Geometry::fill(int16_t x1, int16_t y1, int16_t x2, int16_t y2, int16_t sym,
 {
 	clip(x1, y1);
 	clip(x2, y2);
-	for (int16_t x = x1; x <= x2; x++)
+	x2 = min<int16_t>(x2, consoleWidth - 1);
+	y2 = min<int16_t>(y2, consoleHeight - 1);
+	if (x1 > x2)
 	{
-		for (int16_t y = y1; y <= y2; y++)
-		{
-			simpleDraw(x, y, sym, col);
-		}
+		return;
+	}
+
+	//   
+	CHAR_INFO cell;
+	cell.Char.UnicodeChar = sym;
+	cell.Attributes = col;
+	for (int16_t y = y1; y <= y2; y++)
+	{
+		fill_n(&console[y * consoleWidth + x1], x2 - x1 + 1, cell);
 	}
 }
 
@@ -381,67 +495,98 @@ void Geometry::clip(int16_t& x, int16_t& y)
 void Geometry::shadePolygonScanLine(const vector<Point2D>& points, int16_t sym, int16_t col, int16_t yMin, int16_t yMax,
 	int16_t xMin, int16_t xMax)
 {
-	vector<ScanLineStruct> edges(points.size());
-	int16_t minY, maxY;
-	vector<int16_t> scanex;
-
-	minY = maxY = round(points[0].y);
+	// Warnock 
+	yMin = (yMin == -1) ? 0 : max<int16_t>(yMin, 0);
+	yMax = (yMax == -1) ? consoleHeight : min(yMax, consoleHeight);
+	xMin = (xMin == -1) ? 0 : max<int16_t>(xMin, 0);
+	xMax = (xMax == -1) ? consoleWidth - 1 : min<int16_t>(xMax, consoleWidth - 1);
 
+	//  ,     
+	edgeTable.clear();
 	for (size_t i = 0; i < points.size(); i++)
 	{
-		edges[i].x1 = round(points[i].x);
-		edges[i].y1 = round(points[i].y);
-		edges[i].x2 = ((i + 1) == points.size()) ? round(points[0].x) : round(points[i + 1].x);
-		edges[i].y2 = ((i + 1) == points.size()) ? round(points[0].y) : round(points[i + 1].y);
-		edges[i].delX = edges[i].x2 - edges[i].x1;
-		edges[i].delY = edges[i].y2 - edges[i].y1;
-		edges[i].delXY = (edges[i].delY == 0) ? 0 : edges[i].delX / edges[i].delY;
+		const Point2D& p1 = points[i];
+		const Point2D& p2 = points[(i + 1) % points.size()];
+		int32_t x1 = lroundf(p1.x), y1 = lroundf(p1.y);
+		int32_t x2 = lroundf(p2.x), y2 = lroundf(p2.y);
 
-		if (edges[i].y2 > maxY)
+		if (y1 == y2)
 		{
-			maxY = edges[i].y2;
+			continue;
 		}
-		else if (edges[i].y2 < minY)
+		if (y1 > y2)
 		{
-			minY = edges[i].y2;
+			swap(x1, x2);
+			swap(y1, y2);
 		}
+		if (y2 <= yMin || y1 >= yMax)
+		{
+			continue;
+		}
+
+		ScanLineStruct edge;
+		edge.dx = (static_cast<int64_t>(x2 - x1) << 16) / (y2 - y1);
+		edge.x = (static_cast<int64_t>(x1) << 16) + 0x8000;
+		edge.yStart = static_cast<int16_t>(max(y1, static_cast<int32_t>(yMin)));
+		edge.yEnd = static_cast<int16_t>(min(y2, static_cast<int32_t>(yMax)));
+		edge.x += edge.dx * (edge.yStart - y1);
+		edgeTable.push_back(edge);
+	}
+	if (edgeTable.empty())
+	{
+		return;
 	}
 
-	// Warnock 
-	yMin = (yMin == -1) ? 0 : yMin;
-	yMax = (yMax == -1) ? consoleHeight : yMax;
-	xMin = (xMin == -1) ? 0 : xMin;
-	xMax = (xMax == -1) ? consoleWidth : xMax;
+	sort(edgeTable.begin(), edgeTable.end(), [](const ScanLineStruct& a, const ScanLineStruct& b)
+		{
+			return a.yStart < b.yStart;
+		});
 
-	minY = (minY < yMin) ? yMin : minY;
-	maxY = (maxY > yMax) ? yMax : maxY;
+	CHAR_INFO cell;
+	cell.Char.UnicodeChar = sym;
+	cell.Attributes = col;
 
-	for (int16_t y = minY; y < maxY; y++)
+	//      [yStart, yEnd)
+	activeEdges.clear();
+	size_t nextEdge = 0;
+	for (int16_t y = edgeTable[0].yStart; y < yMax && (nextEdge < edgeTable.size() || !activeEdges.empty()); y++)
 	{
-		for (size_t i = 0; i < points.size(); i++)
+		while (nextEdge < edgeTable.size() && edgeTable[nextEdge].yStart == y)
 		{
-			if ((edges[i].y1 >= y && edges[i].y2 < y) || (edges[i].y1 < y && edges[i].y2 >= y))
+			activeEdges.push_back(edgeTable[nextEdge++]);
+		}
+		activeEdges.erase(remove_if(activeEdges.begin(), activeEdges.end(), [y](const ScanLineStruct& edge)
 			{
-				scanex.push_back(edges[i].x1 + edges[i].delXY * (y - edges[i].y1));
-			}
-			else if (edges[i].y1 == y && edges[i].y2 == y)
+				return edge.yEnd <= y;
+			}), activeEdges.end());
+
+		//         ,  
+		for (size_t i = 1; i < activeEdges.size(); i++)
+		{
+			ScanLineStruct edge = activeEdges[i];
+			size_t j = i;
+			for (; j > 0 && activeEdges[j - 1].x > edge.x; j--)
 			{
-				scanex.push_back(edges[i].x1);
-				scanex.push_back(edges[i].x2);
+				activeEdges[j] = activeEdges[j - 1];
 			}
+			activeEdges[j] = edge;
 		}
-		if (scanex.size())
-		{
-			sort(scanex.begin(), scanex.end());
 
-			for (size_t i = 0; i < scanex.size() - 1; i += 2)
+		//      
+		CHAR_INFO* row = &console[y * consoleWidth];
+		for (size_t i = 0; i + 1 < activeEdges.size(); i += 2)
+		{
+			int64_t x1 = max<int64_t>(activeEdges[i].x >> 16, xMin);
+			int64_t x2 = min<int64_t>(activeEdges[i + 1].x >> 16, xMax);
+			if (x1 <= x2)
 			{
-				int16_t x1, x2;
-				x1 = (scanex[i] < xMin) ? xMin : scanex[i];
-				x2 = (scanex[i + 1] > xMax) ? xMax : scanex[i + 1];
-				drawBresenhamLine(x1, y, x2, y, sym, col);
+				fill_n(row + x1, x2 - x1 + 1, cell);
 			}
-			scanex.clear();
+		}
+
+		for (auto& edge : activeEdges)
+		{
+			edge.x += edge.dx;
 		}
 	}
 }
@@ -488,39 +633,77 @@ void Geometry::shadePolygonFloodFillRecursion(const vector<Point2D>& points, int
 
 		if (consolePtr->Attributes != colEdges && consolePtr->Attributes != col)
 		{
-			makeFloodFill(consolePtr, center.x, center.y, sym, col, colEdges);
+			makeFloodFill(center.x, center.y, sym, col, colEdges);
 		}
 	}
 }
 
-void Geometry::makeFloodFill(CHAR_INFO* consolePtr, int16_t x, int16_t y, int16_t sym, int16_t col, int16_t colEdges)
+void Geometry::makeFloodFill(int16_t x, int16_t y, int16_t sym, int16_t col, int16_t colEdges)
 {
-	auto on_screen = [this](int16_t x, int16_t y)
+	auto inside = [this, col, colEdges](CHAR_INFO* row, int16_t x)
 	{
-		if (x >= 0.0f && x < consoleWidth && y >= 0.0f && y < consoleHeight)
-		{
-			return true;
-		}
-		return false;
+		return x >= 0 && x < consoleWidth && row[x].Attributes != colEdges && row[x].Attributes != col;
 	};
-	simpleDraw(x, y, sym, col);
-	consolePtr = &console[(int16_t)y * consoleWidth + (int16_t)x];
-
-	if (on_screen(x, y - 1) && (consolePtr - consoleWidth)->Attributes != colEdges && (consolePtr - consoleWidth)->Attributes != col)
-	{
-		makeFloodFill(consolePtr, x, y - 1, sym, col, colEdges);
-	}
-	if (on_screen(x, y + 1) && (consolePtr + consoleWidth)->Attributes != colEdges && (consolePtr + consoleWidth)->Attributes != col)
-	{
-		makeFloodFill(consolePtr, x, y + 1, sym, col, colEdges);
-	}
-	if (on_screen(x - 1, y) && (consolePtr - 1)->Attributes != colEdges && (consolePtr - 1)->Attributes != col)
+	auto set = [sym, col](CHAR_INFO* row, int16_t x)
 	{
-		makeFloodFill(consolePtr, x - 1, y, sym, col, colEdges);
-	}
-	if (on_screen(x + 1, y) && (consolePtr + 1)->Attributes != colEdges && (consolePtr + 1)->Attributes != col)
+		row[x].Char.UnicodeChar = sym;
+		row[x].Attributes = col;
+	};
+
+	//       
+	fillStack.clear();
+	fillStack.push_back({ x, x, y, 1 });
+	fillStack.push_back({ x, x, (int16_t)(y - 1), -1 });
+
+	while (!fillStack.empty())
 	{
-		makeFloodFill(consolePtr, x + 1, y, sym, col, colEdges);
+		FillSpan span = fillStack.back();
+		fillStack.pop_back();
+
+		if (span.y < 0 || span.y >= consoleHeight)
+		{
+			continue;
+		}
+
+		CHAR_INFO* row = &console[span.y * consoleWidth];
+		int16_t x1 = span.x1;
+		int16_t x2 = span.x2;
+		int16_t left = x1;
+
+		if (inside(row, left))
+		{
+			while (inside(row, left - 1))
+			{
+				left--;
+				set(row, left);
+			}
+			if (left < x1)
+			{
+				fillStack.push_back({ left, (int16_t)(x1 - 1), (int16_t)(span.y - span.dy), (int16_t)-span.dy });
+			}
+		}
+		while (x1 <= x2)
+		{
+			while (inside(row, x1))
+			{
+				set(row, x1);
+				x1++;
+			}
+			if (x1 > left)
+			{
+				fillStack.push_back({ left, (int16_t)(x1 - 1), (int16_t)(span.y + span.dy), span.dy });
+			}
+			if (x1 - 1 > x2)
+			{
+				fillStack.push_back({ (int16_t)(x2 + 1), (int16_t)(x1 - 1), (int16_t)(span.y - span.dy), (int16_t)-span.dy });
+			}
+			x1++;
+			while (x1 < x2 && !inside(row, x1))
+			{
+				x1++;
+			}
+			left = x1;
+		}
 	}
 }
 
@@ -564,10 +747,10 @@ bool Geometry::checkPointAndSegment(const Point3D& start, const Point3D& p, cons
 	return false;
 }
 
-void Geometry::paintAlgorithm(vector<triangle>& vecTrianglesToRaster, Point3D& viewPoint, Point3D& barycenter, int16_t sym, int16_t col, int16_t colEdge)
+void Geometry::paintAlgorithm(FrameVector<triangle>& vecTrianglesToRaster, Point3D& viewPoint, Point3D& barycenter, int16_t sym, int16_t col, int16_t colEdge)
 {
 	Point3D vec1, vec2;
-	vector<triangle> vecVisibleSurfaces;
+	FrameVector<triangle> vecVisibleSurfaces(frameArena);
 	bool itsEdge = false;
 
 	for (auto& tri : vecTrianglesToRaster)
@@ -602,14 +785,13 @@ void Geometry::paintAlgorithm(vector<triangle>& vecTrianglesToRaster, Point3D& v
 			}
 			if (!itsEdge)
 			{
-				vector<Point2D> points(3);
 				for (int16_t i = 0; i < 3; i++)
 				{
-					points[i].x = tri.points[i].x;
-					points[i].y = tri.points[i].y;
+					trianglePoints[i].x = tri.points[i].x;
+					trianglePoints[i].y = tri.points[i].y;
 				}
-				drawPolygon(points, sym, FG_YELLOW);
-				shadePolygonFloodFillRecursion(points, sym, col, FG_YELLOW);
+				drawPolygon(trianglePoints, sym, FG_YELLOW);
+				shadePolygonFloodFillRecursion(trianglePoints, sym, col, FG_YELLOW);
 				vecVisibleSurfaces.push_back(tri);
 			}
 			itsEdge = false;
@@ -617,37 +799,527 @@ void Geometry::paintAlgorithm(vector<triangle>& vecTrianglesToRaster, Point3D& v
 	}
 }
 
-void Geometry::drawShadow(vector<triangle>& vecTrianglesToRaster, Point3D& light)
+void Geometry::drawShadow(FrameVector<triangle>& vecTrianglesToRaster, Point3D& light)
 {
-	vector<triangle> vecShadow = vecTrianglesToRaster;
+	buildShadowMap(vecTrianglesToRaster, light);
+	resolveShadow();
+}
+
+Geometry::Point3D Geometry::toLightSpace(const Point3D& point)
+{
+	//      ,       
+	float k = point.y / shadowLight[1];
+	float z = -point.z * point.w - shadowLight[2] * k;
+	return Point3D(point.x - shadowLight[0] * k, 0.95f * static_cast<float>(consoleHeight) + z * 10.0f * subcellRows, point.y);
+}
 
-	for (auto& tri : vecShadow)
+void Geometry::buildShadowMap(const FrameVector<triangle>& casters, Point3D& light)
+{
+	shadowLight[0] = light.x;
+	shadowLight[1] = light.y;
+	shadowLight[2] = light.z;
+	shadowWidth = (consoleWidth + SHADOW_MAP_SCALE - 1) / SHADOW_MAP_SCALE;
+	shadowHeight = (consoleHeight + SHADOW_MAP_SCALE - 1) / SHADOW_MAP_SCALE;
+	shadowMap.assign(shadowWidth * shadowHeight, INFINITY);
+	shadowMinX = shadowMinY = INT16_MAX;
+	shadowMaxX = shadowMaxY = -1;
+
+	//         
+	for (auto& tri : casters)
 	{
-		for (int16_t i = 0; i < 3; i++)
+		Point3D p[3];
+		for (int16_t k = 0; k < 3; k++)
+		{
+			p[k] = toLightSpace(tri.points[k]);
+			p[k].x /= SHADOW_MAP_SCALE;
+			p[k].y /= SHADOW_MAP_SCALE;
+		}
+
+		float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+		if (fabsf(area) < 0.00001f)
+		{
+			continue;
+		}
+
+		float minX = max(0.0f, ceilf(min(p[0].x, min(p[1].x, p[2].x)) - 0.5f));
+		float maxX = min(shadowWidth - 1.0f, floorf(max(p[0].x, max(p[1].x, p[2].x)) - 0.5f));
+		float minY = max(0.0f, ceilf(min(p[0].y, min(p[1].y, p[2].y)) - 0.5f));
+		float maxY = min(shadowHeight - 1.0f, floorf(max(p[0].y, max(p[1].y, p[2].y)) - 0.5f));
+		if (minX > maxX || minY > maxY)
+		{
+			continue;
+		}
+
+		float sign = (area > 0.0f) ? 1.0f : -1.0f;
+		float invArea = 1.0f / fabsf(area);
+		for (int16_t y = static_cast<int16_t>(minY); y <= static_cast<int16_t>(maxY); y++)
+		{
+			float cy = y + 0.5f;
+			float* row = &shadowMap[y * shadowWidth];
+
+			for (int16_t x = static_cast<int16_t>(minX); x <= static_cast<int16_t>(maxX); x++)
+			{
+				float cx = x + 0.5f;
+				float w0 = ((p[2].x - p[1].x) * (cy - p[1].y) - (p[2].y - p[1].y) * (cx - p[1].x)) * sign;
+				float w1 = ((p[0].x - p[2].x) * (cy - p[2].y) - (p[0].y - p[2].y) * (cx - p[2].x)) * sign;
+				float w2 = ((p[1].x - p[0].x) * (cy - p[0].y) - (p[1].y - p[0].y) * (cx - p[0].x)) * sign;
+
+				if (w0 >= 0.0f && w1 >= 0.0f && w2 >= 0.0f)
+				{
+					float depth = (w0 * p[0].z + w1 * p[1].z + w2 * p[2].z) * invArea;
+					row[x] = min(row[x], depth);
+					shadowMinX = min(shadowMinX, x);
+					shadowMaxX = max(shadowMaxX, x);
+					shadowMinY = min(shadowMinY, y);
+					shadowMaxY = max(shadowMaxY, y);
+				}
+			}
+		}
+	}
+}
+
+void Geometry::resolveShadow(int16_t sym, int16_t col)
+{
+	CHAR_INFO cell;
+	cell.Char.UnicodeChar = sym;
+	cell.Attributes = col;
+
+	//         
+	for (int16_t my = shadowMinY; my <= shadowMaxY; my++)
+	{
+		const float* row = &shadowMap[my * shadowWidth];
+		int16_t y1 = my * SHADOW_MAP_SCALE;
+		int16_t y2 = min<int16_t>(y1 + SHADOW_MAP_SCALE, consoleHeight);
+
+		for (int16_t mx = shadowMinX; mx <= shadowMaxX; mx++)
 		{
-			tri.points[i].z *= tri.points[i].w;
-			tri.points[i].x -= light.x * (tri.points[i].y / light.y);
-			tri.points[i].z = -tri.points[i].z - light.z * (tri.points[i].y / light.y);
-			tri.points[i].y = 0.95f * static_cast<float>(consoleHeight) + tri.points[i].z * 10.0f;
+			if (row[mx] == INFINITY)
+			{
+				continue;
+			}
+			int16_t start = mx;
+			while (mx + 1 <= shadowMaxX && row[mx + 1] != INFINITY)
+			{
+				mx++;
+			}
+
+			int16_t x1 = start * SHADOW_MAP_SCALE;
+			int16_t x2 = min<int16_t>((mx + 1) * SHADOW_MAP_SCALE, consoleWidth);
+			for (int16_t y = y1; y < y2; y++)
+			{
+				fill_n(&console[y * consoleWidth + x1], x2 - x1, cell);
+			}
 		}
 	}
+}
 
-	vector<Point2D> lines(3);
+bool Geometry::isInShadow(const Point3D& point, float bias)
+{
+	if (shadowMap.empty())
+	{
+		return false;
+	}
 
-	for (auto& tri : vecShadow)
+	Point3D p = toLightSpace(point);
+	float x = floorf(p.x / SHADOW_MAP_SCALE);
+	float y = floorf(p.y / SHADOW_MAP_SCALE);
+	if (x < 0.0f || x >= shadowWidth || y < 0.0f || y >= shadowHeight)
 	{
-		for (int16_t i = 0; i < 3; i++)
+		return false;
+	}
+	return shadowMap[static_cast<size_t>(y) * shadowWidth + static_cast<size_t>(x)] < p.z - bias;
+}
+
+void Geometry::clearDepth()
+{
+	fill_n(depthBuffer.begin(), depthBuffer.size(), INFINITY);
+}
+
+void Geometry::rasterizeTriangle(const triangle& tri, int16_t sym, int16_t col, int16_t yMin, int16_t yMax,
+	int16_t xMin, int16_t xMax)
+{
+	const Point3D& p0 = tri.points[0];
+	const Point3D& p1 = tri.points[1];
+	const Point3D& p2 = tri.points[2];
+
+	float area = (p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x);
+	if (fabsf(area) < 0.00001f)
+	{
+		return;
+	}
+
+	//     
+	xMin = (xMin == -1) ? 0 : xMin;
+	xMax = (xMax == -1) ? consoleWidth - 1 : xMax;
+	yMin = (yMin == -1) ? 0 : yMin;
+	yMax = (yMax == -1) ? consoleHeight - 1 : yMax;
+
+	int16_t minX = (int16_t)max((float)xMin, floorf(min(p0.x, min(p1.x, p2.x))));
+	int16_t maxX = (int16_t)min((float)xMax, ceilf(max(p0.x, max(p1.x, p2.x))));
+	int16_t minY = (int16_t)max((float)yMin, floorf(min(p0.y, min(p1.y, p2.y))));
+	int16_t maxY = (int16_t)min((float)yMax, ceilf(max(p0.y, max(p1.y, p2.y))));
+	if (minX > maxX || minY > maxY)
+	{
+		return;
+	}
+
+	// и ,    
+	float sign = (area > 0.0f) ? 1.0f : -1.0f;
+	float invArea = 1.0f / fabsf(area);
+	float a0 = (p1.y - p2.y) * sign, b0 = (p2.x - p1.x) * sign;
+	float a1 = (p2.y - p0.y) * sign, b1 = (p0.x - p2.x) * sign;
+	float a2 = (p0.y - p1.y) * sign, b2 = (p1.x - p0.x) * sign;
+	float w0Row = ((p2.x - p1.x) * (minY - p1.y) - (p2.y - p1.y) * (minX - p1.x)) * sign;
+	float w1Row = ((p0.x - p2.x) * (minY - p2.y) - (p0.y - p2.y) * (minX - p2.x)) * sign;
+	float w2Row = ((p1.x - p0.x) * (minY - p0.y) - (p1.y - p0.y) * (minX - p0.x)) * sign;
+
+	for (int16_t y = minY; y <= maxY; y++)
+	{
+		float w0 = w0Row, w1 = w1Row, w2 = w2Row;
+		CHAR_INFO* row = &console[y * consoleWidth];
+		float* depthRow = &depthBuffer[y * consoleWidth];
+
+		for (int16_t x = minX; x <= maxX; x++)
 		{
-			lines[i].x = tri.points[i].x;
-			lines[i].y = tri.points[i].y;
+			if (w0 >= 0.0f && w1 >= 0.0f && w2 >= 0.0f)
+			{
+				float z = (w0 * p0.z + w1 * p1.z + w2 * p2.z) * invArea;
+				if (z < depthRow[x])
+				{
+					depthRow[x] = z;
+					row[x].Char.UnicodeChar = sym;
+					row[x].Attributes = col;
+				}
+			}
+			w0 += a0;
+			w1 += a1;
+			w2 += a2;
 		}
-		shadePolygonScanLine(lines, PIXEL_SOLID, BG_GREY);
+		w0Row += b0;
+		w1Row += b1;
+		w2Row += b2;
 	}
 }
 
+void Geometry::setThreadCount(size_t count)
+{
+	workerPool.start(max<size_t>(count, 1));
+}
+
+void Geometry::rasterizeTrianglesTiled(const FrameVector<triangle>& tris)
+{
+	int16_t tilesX = (consoleWidth + TILE_WIDTH - 1) / TILE_WIDTH;
+	int16_t tilesY = (consoleHeight + TILE_HEIGHT - 1) / TILE_HEIGHT;
+	size_t tileCount = static_cast<size_t>(tilesX) * tilesY;
+
+	//     , false    
+	auto tileRange = [&](const triangle& tri, int16_t& tx1, int16_t& tx2, int16_t& ty1, int16_t& ty2)
+	{
+		float minX = min(tri.points[0].x, min(tri.points[1].x, tri.points[2].x));
+		float maxX = max(tri.points[0].x, max(tri.points[1].x, tri.points[2].x));
+		float minY = min(tri.points[0].y, min(tri.points[1].y, tri.points[2].y));
+		float maxY = max(tri.points[0].y, max(tri.points[1].y, tri.points[2].y));
+
+		if (maxX < 0.0f || maxY < 0.0f || minX >= consoleWidth || minY >= consoleHeight)
+		{
+			return false;
+		}
+
+		tx1 = (int16_t)max(0.0f, floorf(minX)) / TILE_WIDTH;
+		tx2 = (int16_t)min(consoleWidth - 1.0f, ceilf(maxX)) / TILE_WIDTH;
+		ty1 = (int16_t)max(0.0f, floorf(minY)) / TILE_HEIGHT;
+		ty2 = (int16_t)min(consoleHeight - 1.0f, ceilf(maxY)) / TILE_HEIGHT;
+		return true;
+	};
+
+	//        ,  
+	FrameVector<uint32_t> tileStart(tileCount + 1, 0, frameArena);
+	int16_t tx1, tx2, ty1, ty2;
+	for (auto& tri : tris)
+	{
+		if (tileRange(tri, tx1, tx2, ty1, ty2))
+		{
+			for (int16_t ty = ty1; ty <= ty2; ty++)
+			{
+				for (int16_t tx = tx1; tx <= tx2; tx++)
+				{
+					tileStart[ty * tilesX + tx + 1]++;
+				}
+			}
+		}
+	}
+	for (size_t tile = 0; tile < tileCount; tile++)
+	{
+		tileStart[tile + 1] += tileStart[tile];
+	}
+
+	FrameVector<uint32_t> tileItems(tileStart[tileCount], frameArena);
+	FrameVector<uint32_t> tileFill(tileStart.begin(), tileStart.end() - 1, frameArena);
+	for (size_t i = 0; i < tris.size(); i++)
+	{
+		if (tileRange(tris[i], tx1, tx2, ty1, ty2))
+		{
+			for (int16_t ty = ty1; ty <= ty2; ty++)
+			{
+				for (int16_t tx = tx1; tx <= tx2; tx++)
+				{
+					tileItems[tileFill[ty * tilesX + tx]++] = static_cast<uint32_t>(i);
+				}
+			}
+		}
+	}
+
+	//   ,       
+	workerPool.run(tileCount, [&](size_t tile)
+		{
+			int16_t xMin = (int16_t)(tile % tilesX) * TILE_WIDTH;
+			int16_t yMin = (int16_t)(tile / tilesX) * TILE_HEIGHT;
+			int16_t xMax = min<int16_t>(xMin + TILE_WIDTH, consoleWidth) - 1;
+			int16_t yMax = min<int16_t>(yMin + TILE_HEIGHT, consoleHeight) - 1;
+
+			for (uint32_t k = tileStart[tile]; k < tileStart[tile + 1]; k++)
+			{
+				const triangle& tri = tris[tileItems[k]];
+				rasterizeTriangle(tri, tri.sym, tri.col, yMin, yMax, xMin, xMax);
+			}
+		}
+	);
+}
+
+void Geometry::sortByDepth(FrameVector<triangle>& tris)
+{
+	struct DepthKey
+	{
+		uint32_t key, index;
+	};
+
+	size_t count = tris.size();
+	FrameVector<DepthKey> keys(count, frameArena);
+	FrameVector<DepthKey> scratch(count, frameArena);
+
+	//  float        ,       
+	for (size_t i = 0; i < count; i++)
+	{
+		float z = (tris[i].points[0].z + tris[i].points[1].z + tris[i].points[2].z) / 3.0f;
+		uint32_t bits;
+		memcpy(&bits, &z, sizeof(bits));
+		bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+		keys[i] = { ~bits, static_cast<uint32_t>(i) };
+	}
+
+	//      ,  ,      
+	for (int16_t shift = 0; shift < 32; shift += 8)
+	{
+		size_t histogram[256] = {};
+		for (auto& item : keys)
+		{
+			histogram[(item.key >> shift) & 0xFF]++;
+		}
+		if (histogram[(keys.empty() ? 0 : keys[0].key >> shift) & 0xFF] == count)
+		{
+			continue;
+		}
+
+		size_t offset = 0;
+		for (auto& bucket : histogram)
+		{
+			size_t size = bucket;
+			bucket = offset;
+			offset += size;
+		}
+		for (auto& item : keys)
+		{
+			scratch[histogram[(item.key >> shift) & 0xFF]++] = item;
+		}
+		keys.swap(scratch);
+	}
+
+	FrameVector<triangle> sorted(frameArena);
+	sorted.reserve(count);
+	for (auto& item : keys)
+	{
+		sorted.push_back(tris[item.index]);
+	}
+	tris.swap(sorted);
+}
+
+void Geometry::cullTriangles(const Mesh& mesh, const VertexBuffer& view, const VertexBuffer& screen, ViewVolume& volume,
+	FrameVector<triangle>& visible, FrameVector<triangle>& casters, int16_t colEven, int16_t colOdd,
+	size_t firstTriangle, size_t triangleCount)
+{
+	//    z = plane, side   
+	auto clipPolygon = [](const Point3D* in, size_t count, Point3D* out, float plane, float side)
+	{
+		size_t result = 0;
+		for (size_t k = 0; k < count; k++)
+		{
+			const Point3D& a = in[k];
+			const Point3D& b = in[(k + 1) % count];
+			float da = (a.z - plane) * side;
+			float db = (b.z - plane) * side;
+
+			if (da >= 0.0f)
+			{
+				out[result++] = a;
+			}
+			if ((da >= 0.0f) != (db >= 0.0f))
+			{
+				float s = da / (da - db);
+				out[result++] = Point3D(a.x + (b.x - a.x) * s, a.y + (b.y - a.y) * s, a.z + (b.z - a.z) * s);
+			}
+		}
+		return result;
+	};
+
+	//   ,    projectVertices,   
+	auto project = [&](Point3D& p)
+	{
+		Point3D clip = multiplyMatrix(volume.projection, p);
+		float invW = 1.0f / clip.w;
+		return Point3D(clip.x * invW * volume.scaleX + volume.offsetX, clip.y * invW * volume.scaleY + volume.offsetY,
+			clip.z * invW, clip.w);
+	};
+
+	auto offScreen = [&](const triangle& tri)
+	{
+		const Point3D* p = tri.points;
+		return (p[0].x < 0.0f && p[1].x < 0.0f && p[2].x < 0.0f) ||
+			(p[0].y < 0.0f && p[1].y < 0.0f && p[2].y < 0.0f) ||
+			(p[0].x >= consoleWidth && p[1].x >= consoleWidth && p[2].x >= consoleWidth) ||
+			(p[0].y >= consoleHeight && p[1].y >= consoleHeight && p[2].y >= consoleHeight);
+	};
+
+	size_t end = min(mesh.indices.size() / 3, firstTriangle + min(triangleCount, mesh.indices.size() / 3)) * 3;
+	for (size_t i = firstTriangle * 3; i < end; i += 3)
+	{
+		const uint32_t* index = &mesh.indices[i];
+		Point3D v[3];
+		int16_t nearCount = 0, farCount = 0;
+
+		for (int16_t k = 0; k < 3; k++)
+		{
+			v[k] = Point3D(view.x[index[k]], view.y[index[k]], view.z[index[k]]);
+			nearCount += v[k].z < volume.zNear;
+			farCount += v[k].z > volume.zFar;
+		}
+		if (nearCount == 3 || farCount == 3)
+		{
+			continue;
+		}
+
+		//   ,     
+		Point3D edge1 = v[1] - v[0];
+		Point3D edge2 = v[2] - v[0];
+		Point3D normal = vectorCrossProduct(edge1, edge2);
+		bool isFront = vectorDotProduct(normal, v[0]) < 0.0f;
+		int16_t col = (mesh.faceIds[i / 3] % 2 == 0) ? colEven : colOdd;
+		size_t first = casters.size();
+
+		if (nearCount == 0 && farCount == 0)
+		{
+			triangle tri;
+			for (int16_t k = 0; k < 3; k++)
+			{
+				tri.points[k] = Point3D(screen.x[index[k]], screen.y[index[k]], screen.z[index[k]], screen.w[index[k]]);
+			}
+			tri.col = col;
+			casters.push_back(tri);
+		}
+		else
+		{
+			//      ,    
+			Point3D polygon[6], clipped[6];
+			size_t count = clipPolygon(v, 3, clipped, volume.zNear, 1.0f);
+			count = clipPolygon(clipped, count, polygon, volume.zFar, -1.0f);
+
+			for (size_t k = 1; k + 1 < count; k++)
+			{
+				triangle tri;
+				tri.points[0] = project(polygon[0]);
+				tri.points[1] = project(polygon[k]);
+				tri.points[2] = project(polygon[k + 1]);
+				tri.col = col;
+				casters.push_back(tri);
+			}
+		}
+
+		if (isFront || !cullBackfaces)
+		{
+			for (size_t j = first; j < casters.size(); j++)
+			{
+				if (!offScreen(casters[j]))
+				{
+					visible.push_back(casters[j]);
+				}
+			}
+		}
+	}
+}
+
+void Geometry::makeFrustumPlanes(matrix4x4& m, ViewVolume& volume, float planes[6][4])
+{
+	//     : sx = x * scaleX + w * offsetX
+	for (int16_t i = 0; i < 4; i++)
+	{
+		float sx = m.m[i][0] * volume.scaleX + m.m[i][3] * volume.offsetX;
+		float sy = m.m[i][1] * volume.scaleY + m.m[i][3] * volume.offsetY;
+		float w = m.m[i][3];
+
+		// 0 <= sx / w <= consoleWidth, 0 <= sy / w <= consoleHeight, zNear <= w <= zFar
+		planes[0][i] = sx;
+		planes[1][i] = w * consoleWidth - sx;
+		planes[2][i] = sy;
+		planes[3][i] = w * consoleHeight - sy;
+		planes[4][i] = w;
+		planes[5][i] = -w;
+	}
+	planes[4][3] -= volume.zNear;
+	planes[5][3] += volume.zFar;
+}
+
+Geometry::Mesh& Geometry::selectLod(Mesh& mesh, const Bvh::Bounds& viewBounds, ViewVolume& volume)
+{
+	if (mesh.lods.empty())
+	{
+		return mesh;
+	}
+
+	//      ;        
+	float center[3], radius = 0.0f;
+	for (int16_t i = 0; i < 3; i++)
+	{
+		center[i] = 0.5f * (viewBounds.min[i] + viewBounds.max[i]);
+		float half = 0.5f * (viewBounds.max[i] - viewBounds.min[i]);
+		radius += half * half;
+	}
+	radius = sqrtf(radius);
+	if (center[2] - radius <= volume.zNear)
+	{
+		return mesh;
+	}
+
+	//    ,    
+	float rx = fabsf(volume.scaleX) * volume.projection.m[0][0] * radius / center[2];
+	float ry = fabsf(volume.scaleY) * volume.projection.m[1][1] * radius / center[2];
+	float area = min(PI * rx * ry, static_cast<float>(consoleWidth) * consoleHeight);
+	size_t budget = static_cast<size_t>(area * LOD_TRIANGLES_PER_CELL);
+
+	//   ,      
+	Mesh* selected = &mesh;
+	for (auto& lod : mesh.lods)
+	{
+		if (lod.indices.size() / 3 < budget)
+		{
+			break;
+		}
+		selected = &lod;
+	}
+	return *selected;
+}
+
 float Geometry::vectorDotProduct(Point3D& v1, Point3D& v2)
 {
-	return (v1.x * v2.x + v1.y * v2.y + v1.z * v2.z);
+	return simdDotProduct(&v1.x, &v2.x);
 }
 
 float Geometry::vectorLength(Point3D& v)
@@ -664,9 +1336,8 @@ Geometry::Point3D Geometry::vectorNormalise(Point3D& v)
 Geometry::Point3D Geometry::vectorCrossProduct(Point3D& v1, Point3D& v2)
 {
 	Point3D v;
-	v.x = v1.y * v2.z - v1.z * v2.y;
-	v.y = v1.z * v2.x - v1.x * v2.z;
-	v.z = v1.x * v2.y - v1.y * v2.x;
+	simdCrossProduct(&v1.x, &v2.x, &v.x);
+	v.w = 1.0f;
 	return v;
 }
 
@@ -682,10 +1353,7 @@ Geometry::Point2D Geometry::multiplyMatrix(matrix3x3& m, Point2D& v)
 Geometry::Point3D Geometry::multiplyMatrix(matrix4x4& m, Point3D& v)
 {
 	Point3D v1;
-	v1.x = v.x * m.m[0][0] + v.y * m.m[1][0] + v.z * m.m[2][0] + v.w * m.m[3][0];
-	v1.y = v.x * m.m[0][1] + v.y * m.m[1][1] + v.z * m.m[2][1] + v.w * m.m[3][1];
-	v1.z = v.x * m.m[0][2] + v.y * m.m[1][2] + v.z * m.m[2][2] + v.w * m.m[3][2];
-	v1.w = v.x * m.m[0][3] + v.y * m.m[1][3] + v.z * m.m[2][3] + v.w * m.m[3][3];
+	simdMultiplyVector(m.m, &v.x, &v1.x);
 	return v1;
 }
 
@@ -701,40 +1369,136 @@ Geometry::matrix4x4 Geometry::makeIdentity()
 
 Geometry::matrix4x4 Geometry::makeRotationX(float fAngleRad)
 {
+	float s, c;
+	fastSinCos(fAngleRad, s, c);
 	matrix4x4 matrix;
 	matrix.m[0][0] = 1.0f;
-	matrix.m[1][1] = cosf(fAngleRad);
-	matrix.m[1][2] = sinf(fAngleRad);
-	matrix.m[2][1] = -sinf(fAngleRad);
-	matrix.m[2][2] = cosf(fAngleRad);
+	matrix.m[1][1] = c;
+	matrix.m[1][2] = s;
+	matrix.m[2][1] = -s;
+	matrix.m[2][2] = c;
 	matrix.m[3][3] = 1.0f;
 	return matrix;
 }
 
 Geometry::matrix4x4 Geometry::makeRotationY(float fAngleRad)
 {
+	float s, c;
+	fastSinCos(fAngleRad, s, c);
 	matrix4x4 matrix;
-	matrix.m[0][0] = cosf(fAngleRad);
-	matrix.m[0][2] = sinf(fAngleRad);
-	matrix.m[2][0] = -sinf(fAngleRad);
+	matrix.m[0][0] = c;
+	matrix.m[0][2] = s;
+	matrix.m[2][0] = -s;
 	matrix.m[1][1] = 1.0f;
-	matrix.m[2][2] = cosf(fAngleRad);
+	matrix.m[2][2] = c;
 	matrix.m[3][3] = 1.0f;
 	return matrix;
 }
 
 Geometry::matrix4x4 Geometry::makeRotationZ(float fAngleRad)
 {
+	float s, c;
+	fastSinCos(fAngleRad, s, c);
 	matrix4x4 matrix;
-	matrix.m[0][0] = cosf(fAngleRad);
-	matrix.m[0][1] = sinf(fAngleRad);
-	matrix.m[1][0] = -sinf(fAngleRad);
-	matrix.m[1][1] = cosf(fAngleRad);
+	matrix.m[0][0] = c;
+	matrix.m[0][1] = s;
+	matrix.m[1][0] = -s;
+	matrix.m[1][1] = c;
 	matrix.m[2][2] = 1.0f;
 	matrix.m[3][3] = 1.0f;
 	return matrix;
 }
 
+Geometry::matrix4x4 Geometry::makeRotationEuler(float angleX, float angleY, float angleZ, float scale)
+{
+	//  RotY * RotX * RotZ * Scale   ,   
+	float sx, cx, sy, cy, sz, cz;
+	fastSinCos(angleX, sx, cx);
+	fastSinCos(angleY, sy, cy);
+	fastSinCos(angleZ, sz, cz);
+
+	matrix4x4 matrix;
+	matrix.m[0][0] = (cy * cz + sy * sx * sz) * scale;
+	matrix.m[0][1] = (cy * sz - sy * sx * cz) * scale;
+	matrix.m[0][2] = sy * cx * scale;
+	matrix.m[1][0] = -cx * sz * scale;
+	matrix.m[1][1] = cx * cz * scale;
+	matrix.m[1][2] = sx * scale;
+	matrix.m[2][0] = (cy * sx * sz - sy * cz) * scale;
+	matrix.m[2][1] = (-sy * sz - cy * sx * cz) * scale;
+	matrix.m[2][2] = cy * cx * scale;
+	matrix.m[3][3] = 1.0f;
+	return matrix;
+}
+
+Geometry::quaternion Geometry::makeQuaternionEuler(float angleX, float angleY, float angleZ)
+{
+	//   ,   makeRotationEuler,   
+	float sx, cx, sy, cy, sz, cz;
+	fastSinCos(angleX * 0.5f, sx, cx);
+	fastSinCos(angleY * 0.5f, sy, cy);
+	fastSinCos(angleZ * 0.5f, sz, cz);
+
+	quaternion q;
+	q.w = cz * cx * cy + sz * sx * sy;
+	q.x = cz * sx * cy + sz * cx * sy;
+	q.y = sz * sx * cy - cz * cx * sy;
+	q.z = sz * cx * cy - cz * sx * sy;
+	return q;
+}
+
+Geometry::quaternion Geometry::slerp(const quaternion& q1, const quaternion& q2, float t)
+{
+	//  : q  -q   
+	float dot = q1.w * q2.w + q1.x * q2.x + q1.y * q2.y + q1.z * q2.z;
+	float sign = (dot < 0.0f) ? -1.0f : 1.0f;
+	dot *= sign;
+
+	float k1 = 1.0f - t, k2 = t * sign;
+	//       ,   
+	if (dot < 0.9995f)
+	{
+		float angle = acosf(dot);
+		float invSin = 1.0f / sinf(angle);
+		k1 = sinf(k1 * angle) * invSin;
+		k2 = sinf(t * angle) * invSin * sign;
+	}
+
+	quaternion q;
+	q.w = k1 * q1.w + k2 * q2.w;
+	q.x = k1 * q1.x + k2 * q2.x;
+	q.y = k1 * q1.y + k2 * q2.y;
+	q.z = k1 * q1.z + k2 * q2.z;
+
+	float length = sqrtf(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+	q.w /= length;
+	q.x /= length;
+	q.y /= length;
+	q.z /= length;
+	return q;
+}
+
+Geometry::matrix4x4 Geometry::makeRotationQuaternion(const quaternion& q, float scale)
+{
+	//   -,      
+	float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+	float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+	float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+	matrix4x4 matrix;
+	matrix.m[0][0] = (1.0f - 2.0f * (yy + zz)) * scale;
+	matrix.m[0][1] = 2.0f * (xy + wz) * scale;
+	matrix.m[0][2] = 2.0f * (xz - wy) * scale;
+	matrix.m[1][0] = 2.0f * (xy - wz) * scale;
+	matrix.m[1][1] = (1.0f - 2.0f * (xx + zz)) * scale;
+	matrix.m[1][2] = 2.0f * (yz + wx) * scale;
+	matrix.m[2][0] = 2.0f * (xz + wy) * scale;
+	matrix.m[2][1] = 2.0f * (yz - wx) * scale;
+	matrix.m[2][2] = (1.0f - 2.0f * (xx + yy)) * scale;
+	matrix.m[3][3] = 1.0f;
+	return matrix;
+}
+
 Geometry::matrix4x4 Geometry::makeScale(float x, float y, float z)
 {
 	matrix4x4 matrix;
@@ -789,12 +1553,181 @@ Geometry::matrix4x4 Geometry::makeProjectionIzometric()
 Geometry::matrix4x4 Geometry::multiplyMatrix(matrix4x4& m1, matrix4x4& m2)
 {
 	matrix4x4 matrix;
-	for (int16_t c = 0; c < 4; c++)
+	simdMultiplyMatrix(m1.m, m2.m, matrix.m);
+	return matrix;
+}
+
+void Geometry::transformVertices(const VertexBuffer& in, matrix4x4& m, VertexBuffer& out)
+{
+	size_t count = in.size();
+	out.resize(count);
+	simdTransformBatch(m.m, in.x.data(), in.y.data(), in.z.data(), in.w.data(),
+		out.x.data(), out.y.data(), out.z.data(), out.w.data(), count);
+}
+
+void Geometry::projectVertices(VertexBuffer& v, float scaleX, float offsetX, float scaleY, float offsetY)
+{
+	simdPerspectiveDivide(v.x.data(), v.y.data(), v.z.data(), v.w.data(), v.size(), scaleX, offsetX, scaleY, offsetY);
+}
+
+Bvh::Bounds Geometry::transformBounds(const Bvh::Bounds& bounds, matrix4x4& m)
+{
+	//        
+	Bvh::Bounds result;
+	for (int16_t j = 0; j < 3; j++)
 	{
-		for (int16_t r = 0; r < 4; r++)
+		result.min[j] = result.max[j] = m.m[3][j];
+		for (int16_t i = 0; i < 3; i++)
 		{
-			matrix.m[r][c] = m1.m[r][0] * m2.m[0][c] + m1.m[r][1] * m2.m[1][c] + m1.m[r][2] * m2.m[2][c] + m1.m[r][3] * m2.m[3][c];
+			float low = m.m[i][j] * bounds.min[i];
+			float high = m.m[i][j] * bounds.max[i];
+			result.min[j] += min(low, high);
+			result.max[j] += max(low, high);
 		}
 	}
-	return matrix;
+	return result;
+}
+
+void Geometry::Mesh::buildIndexBuffer()
+{
+	//     
+	struct VertexKey
+	{
+		uint32_t x, y, z;
+
+		bool operator==(const VertexKey& obj) const
+		{
+			return x == obj.x && y == obj.y && z == obj.z;
+		}
+	};
+	struct VertexKeyHash
+	{
+		size_t operator()(const VertexKey& key) const
+		{
+			return (key.x * 73856093u) ^ (key.y * 19349663u) ^ (key.z * 83492791u);
+		}
+	};
+	auto bits = [](float value)
+	{
+		uint32_t result;
+		value = (value == 0.0f) ? 0.0f : value;
+		memcpy(&result, &value, sizeof(result));
+		return result;
+	};
+
+	unordered_map<VertexKey, uint32_t, VertexKeyHash> lookup;
+	lookup.reserve(tris.size() * 3);
+	vertices = VertexBuffer();
+	indices.clear();
+	indices.reserve(tris.size() * 3);
+
+	for (auto& tri : tris)
+	{
+		for (int16_t i = 0; i < 3; i++)
+		{
+			const Point3D& p = tri.points[i];
+			VertexKey key = { bits(p.x), bits(p.y), bits(p.z) };
+			auto it = lookup.find(key);
+
+			if (it == lookup.end())
+			{
+				uint32_t index = static_cast<uint32_t>(vertices.size());
+				vertices.x.push_back(p.x);
+				vertices.y.push_back(p.y);
+				vertices.z.push_back(p.z);
+				vertices.w.push_back(p.w);
+				it = lookup.emplace(key, index).first;
+			}
+			indices.push_back(it->second);
+		}
+	}
+}
+
+void Geometry::Mesh::orientOutward()
+{
+	//    :     
+	Point3D center;
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		center += Point3D(vertices.x[i], vertices.y[i], vertices.z[i]);
+	}
+	center /= static_cast<float>(max<size_t>(vertices.size(), 1));
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		Point3D a(vertices.x[indices[i]], vertices.y[indices[i]], vertices.z[indices[i]]);
+		Point3D b(vertices.x[indices[i + 1]], vertices.y[indices[i + 1]], vertices.z[indices[i + 1]]);
+		Point3D c(vertices.x[indices[i + 2]], vertices.y[indices[i + 2]], vertices.z[indices[i + 2]]);
+		Point3D edge1 = b - a;
+		Point3D edge2 = c - a;
+		Point3D outward = (a + b + c) / 3.0f - center;
+
+		float nx = edge1.y * edge2.z - edge1.z * edge2.y;
+		float ny = edge1.z * edge2.x - edge1.x * edge2.z;
+		float nz = edge1.x * edge2.y - edge1.y * edge2.x;
+		if (nx * outward.x + ny * outward.y + nz * outward.z < 0.0f)
+		{
+			swap(indices[i + 1], indices[i + 2]);
+		}
+	}
+}
+
+void Geometry::Mesh::buildBvh()
+{
+	vector<Bvh::Bounds> bounds(indices.size() / 3);
+
+	for (size_t t = 0; t < bounds.size(); t++)
+	{
+		bounds[t].reset();
+		for (int16_t k = 0; k < 3; k++)
+		{
+			uint32_t index = indices[t * 3 + k];
+			float point[3] = { vertices.x[index], vertices.y[index], vertices.z[index] };
+			bounds[t].expand(point);
+		}
+	}
+	bvh.build(bounds, 64);
+
+	if (faceIds.size() != bounds.size())
+	{
+		faceIds.resize(bounds.size());
+		for (size_t t = 0; t < faceIds.size(); t++)
+		{
+			faceIds[t] = static_cast<uint32_t>(t);
+		}
+	}
+
+	//     ,      
+	const vector<uint32_t>& order = bvh.getOrder();
+	vector<uint32_t> sorted(indices.size());
+	vector<uint32_t> sortedFaces(faceIds.size());
+	for (size_t t = 0; t < order.size(); t++)
+	{
+		memcpy(&sorted[t * 3], &indices[order[t] * 3], 3 * sizeof(uint32_t));
+		sortedFaces[t] = faceIds[order[t]];
+	}
+	indices.swap(sorted);
+	faceIds.swap(sortedFaces);
+}
+
+void Geometry::Mesh::buildLods()
+{
+	//   -   ,   
+	MeshSimplifier simplifier;
+	lods.clear();
+	const Mesh* source = this;
+
+	while (source->indices.size() / 3 >= 4 * LOD_MIN_TRIANGLES)
+	{
+		size_t sourceTriangles = source->indices.size() / 3;
+		Mesh lod;
+		if (!simplifier.simplify(source->vertices, source->indices, sourceTriangles / 4, lod.vertices, lod.indices) ||
+			lod.indices.size() / 3 > sourceTriangles * 9 / 10)
+		{
+			break;
+		}
+		lod.buildBvh();
+		lods.push_back(move(lod));
+		source = &lods.back();
+	}
 }
\ No newline at end of file
@@ -1,8 +1,18 @@
 #ifndef _GRAPHICS_H_
 #define _GRAPHICS_H_
 
-#include <Windows.h>
+#include "Bvh.h"
+#include "FrameScheduler.h"
+#include "FramePipeline.h"
+#include "FrameArena.h"
+#include "FastTrig.h"
+#include "AllocationCounter.h"
+#include "Presenter.h"
+#include "Profiler.h"
+#include "SimdMath.h"
+#include "WorkerPool.h"
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <chrono>
 #include <queue>
@@ -11,6 +21,14 @@
 #include <algorithm>
 
 constexpr float PI = 3.14159f;
+constexpr int16_t TILE_WIDTH = 64;
+constexpr int16_t TILE_HEIGHT = 32;
+constexpr int16_t SHADOW_MAP_SCALE = 2;
+constexpr uint32_t IDLE_WAIT_MS = 50;
+//  :       
+constexpr size_t LOD_MIN_TRIANGLES = 256;
+//          
+constexpr float LOD_TRIANGLES_PER_CELL = 2.0f;
 
 using namespace std;
 
@@ -40,16 +58,56 @@ enum PIXEL_TYPE
 	PIXEL_QUARTER = 0x2591,
 };
 
+enum RENDER_MODE
+{
+	RENDER_PAINTER,
+	RENDER_ZBUFFER,
+};
+
+//             
+enum SUBCELL_MODE
+{
+	SUBCELL_OFF,
+	// 1x2:  ,   ,  
+	SUBCELL_HALF_BLOCK,
+	// 2x4:     
+	SUBCELL_BRAILLE,
+};
+
 class Geometry
 {
+	//        
+	friend class SceneGraph;
+	friend class MeshSimplifier;
+
 protected:
 	wstring appName;
 	int16_t consoleWidth, consoleHeight;
-	SMALL_RECT rectWindow;
-	HANDLE outConsoleHandle;
-	HANDLE inConsoleHandle;
-	HANDLE orgConsoleHandle;
-	CHAR_INFO* console;								
+	Presenter* presenter;
+	CHAR_INFO* console;
+	FramePipeline pipeline;
+	RENDER_MODE renderMode;
+	SUBCELL_MODE subcellMode;
+	//        
+	vector<CHAR_INFO> subcellBuffer;
+	int16_t subcellColumns, subcellRows;
+	vector<float> depthBuffer;
+	vector<float> shadowMap;
+	int16_t shadowWidth, shadowHeight;
+	int16_t shadowMinX, shadowMaxX, shadowMinY, shadowMaxY;
+	float shadowLight[3];
+	WorkerPool workerPool;
+	Profiler profiler;
+	FrameScheduler scheduler;
+	//   ,    
+	FrameArena frameArena;
+	uint64_t frameAllocations;
+	//    , 0 -  
+	uint32_t frameLimit;
+	uint32_t frameCount;
+	bool showProfiler;								
+	bool cullBackfaces;
+	bool redrawRequested;
 
 	struct KeyState
 	{
@@ -69,17 +127,19 @@ protected:
 	int16_t mouseY;
 
 	int16_t error(const wchar_t* msg);
+	bool updateInput();
 	virtual void userCreateHandle() = 0;
-	virtual void userUpdateHandle(float fElapsedTime) = 0;
-
-private:
-	void setConsoleDefault();
+	//    ,      
+	virtual void userFixedUpdateHandle(float /*fFixedStep*/) {}
+	//  false,         
+	virtual bool userUpdateHandle(float fElapsedTime) = 0;
 
 public:
 	Geometry();
 	~Geometry();
 
 	int16_t constructConsole(int16_t width, int16_t height, int16_t fontW, int16_t fontH, wstring consoleName = L"3D model");
+	void setPresenter(Presenter* newPresenter);
 	int16_t getConsoleWidth();
 	int16_t getConsoleHeight();
 	KeyState& getKey(int16_t keyId);
@@ -99,6 +159,53 @@ public:
 	{ 
 		return consoleInFocus; 
 	}
+	Profiler& getProfiler()
+	{
+		return profiler;
+	}
+	FrameScheduler& getScheduler()
+	{
+		return scheduler;
+	}
+	void setFrameLimit(uint32_t limit)
+	{
+		frameLimit = limit;
+	}
+	uint32_t getFrameCount()
+	{
+		return frameCount;
+	}
+	//       
+	uint64_t getFrameAllocations()
+	{
+		return frameAllocations;
+	}
+	void setRenderMode(RENDER_MODE mode)
+	{
+		renderMode = mode;
+	}
+	RENDER_MODE getRenderMode()
+	{
+		return renderMode;
+	}
+	//       
+	void invalidate()
+	{
+		redrawRequested = true;
+	}
+	void setBackfaceCulling(bool value)
+	{
+		cullBackfaces = value;
+	}
+	bool getBackfaceCulling()
+	{
+		return cullBackfaces;
+	}
+	void setSubcellMode(SUBCELL_MODE mode);
+	SUBCELL_MODE getSubcellMode()
+	{
+		return subcellMode;
+	}
 	void run();
 
 //    
@@ -182,49 +289,36 @@ protected:
 		}
 	};
 	//   
+	//   : x   16.16     
 	struct ScanLineStruct
 	{
-		int16_t x1, x2, y1, y2;
-		float delX, delY, delXY, delYX;
-
-		ScanLineStruct()
-		{
-			x1 = x2 = y1 = y2 = 0;
-			delX = delY = delXY = delYX = 0.0f;
-		}
+		int64_t x, dx;
+		int16_t yStart, yEnd;
+	};
 
-		ScanLineStruct& operator=(const ScanLineStruct& obj)
-		{
-			x1 = obj.x1;
-			x2 = obj.x2;
-			y1 = obj.y1;
-			y2 = obj.y2;
-			delX = obj.delX;
-			delY = obj.delY;
-			delXY = obj.delXY;
-			delYX = obj.delYX;
-			return *this;
-		}
+	//   
+	struct FillSpan
+	{
+		int16_t x1, x2, y, dy;
 	};
 
-	struct matrix4x4
+	struct alignas(16) matrix4x4
 	{
 		float m[4][4] = { 0 };
 
 		matrix4x4 operator*(matrix4x4& m1)
 		{
 			matrix4x4 matrix;
-			for (int16_t c = 0; c < 4; c++)
-			{
-				for (int16_t r = 0; r < 4; r++)
-				{
-					matrix.m[r][c] = m[r][0] * m1.m[0][c] + m[r][1] * m1.m[1][c] + m[r][2] * m1.m[2][c] + m[r][3] * m1.m[3][c];
-				}
-			}
+			simdMultiplyMatrix(m, m1.m, matrix.m);
 			return matrix;
 		}
 	};
-	struct Point3D
+	//   
+	struct quaternion
+	{
+		float w = 1.0f, x = 0.0f, y = 0.0f, z = 0.0f;
+	};
+	struct alignas(16) Point3D
 	{
 		float x, y, z, w;
 
@@ -344,14 +438,59 @@ protected:
 		}
 	};
 
+	//     
+	struct VertexBuffer
+	{
+		vector<float> x, y, z, w;
+
+		void resize(size_t count)
+		{
+			x.resize(count);
+			y.resize(count);
+			z.resize(count);
+			w.resize(count, 1.0f);
+		}
+		size_t size() const
+		{
+			return x.size();
+		}
+	};
+
 	struct Mesh
 	{
 		vector<triangle> tris;
+
+		//   
+		VertexBuffer vertices;
+		vector<uint32_t> indices;
+		//      ,     
+		vector<uint32_t> faceIds;
+
+		//     
+		Bvh bvh;
+
+		//   ,    
+		vector<Mesh> lods;
+
+		void buildIndexBuffer();
+		void orientOutward();
+		void buildBvh();
+		void buildLods();
+	};
+
+	//         
+	struct ViewVolume
+	{
+		matrix4x4 projection;
+		float zNear, zFar;
+		float scaleX, offsetX, scaleY, offsetY;
 	};
 
 public: 
 	//  
 	void simpleDraw(int16_t x, int16_t y, int16_t sym = ' ', int16_t col = BG_WHITE);
+	void drawString(int16_t x, int16_t y, const string& text, int16_t col = FG_WHITE);
+	void drawProfilerOverlay();
 	void drawBresenhamLine(int16_t x1, int16_t y1, int16_t x2, int16_t y2, int16_t sym = ' ', int16_t col = BG_WHITE);
 	void drawPolygon(vector<Point2D>& points, int16_t sym = ' ', int16_t col = BG_WHITE);
 	void fill(int16_t x1, int16_t y1, int16_t x2, int16_t y2, int16_t sym = PIXEL_SOLID, int16_t col = FG_BLACK);
@@ -360,12 +499,42 @@ public:
 		int16_t yMin = -1, int16_t yMax = -1, int16_t xMin = -1, int16_t xMax = -1);
 	void shadePolygonFloodFillRecursion(const vector<Point2D>& points, int16_t sym = ' ',
 		int16_t col = BG_WHITE, int16_t colEdges = BG_RED);
-	void paintAlgorithm(vector<triangle>& vecTrianglesToRaster, Point3D& viewPoint, Point3D& barycenter,
+	void paintAlgorithm(FrameVector<triangle>& vecTrianglesToRaster, Point3D& viewPoint, Point3D& barycenter,
 		int16_t sym = PIXEL_SOLID, int16_t col = FG_YELLOW, int16_t colEdge = BG_RED);
-	void drawShadow(vector<triangle>& vecTrianglesToRaster, Point3D& light);
+	void drawShadow(FrameVector<triangle>& vecTrianglesToRaster, Point3D& light);
+	void buildShadowMap(const FrameVector<triangle>& casters, Point3D& light);
+	void resolveShadow(int16_t sym = PIXEL_SOLID, int16_t col = BG_GREY);
+	bool isInShadow(const Point3D& point, float bias = 2.0f * SHADOW_MAP_SCALE);
+	void clearDepth();
+	void rasterizeTriangle(const triangle& tri, int16_t sym = PIXEL_SOLID, int16_t col = FG_WHITE,
+		int16_t yMin = -1, int16_t yMax = -1, int16_t xMin = -1, int16_t xMax = -1);
+	void rasterizeTrianglesTiled(const FrameVector<triangle>& tris);
+	void sortByDepth(FrameVector<triangle>& tris);
+	void setThreadCount(size_t count);
+	void cullTriangles(const Mesh& mesh, const VertexBuffer& view, const VertexBuffer& screen, ViewVolume& volume,
+		FrameVector<triangle>& visible, FrameVector<triangle>& casters, int16_t colEven = BG_BLUE, int16_t colOdd = FG_RED,
+		size_t firstTriangle = 0, size_t triangleCount = SIZE_MAX);
+	void makeFrustumPlanes(matrix4x4& m, ViewVolume& volume, float planes[6][4]);
+	Mesh& selectLod(Mesh& mesh, const Bvh::Bounds& viewBounds, ViewVolume& volume);
+
+protected:
+	//    OBJ   
+	bool loadMeshObj(const string& path, Mesh& mesh);
+	bool loadMeshBinary(const string& path, Mesh& mesh);
+	bool saveMeshBinary(const string& path, const Mesh& mesh);
 
 private:
-	void makeFloodFill(CHAR_INFO* consolePtr, int16_t x, int16_t y, int16_t sym, int16_t col, int16_t colEdges);
+	vector<FillSpan> fillStack;
+	vector<ScanLineStruct> edgeTable;
+	vector<ScanLineStruct> activeEdges;
+	vector<Point2D> trianglePoints;
+
+	void makeFloodFill(int16_t x, int16_t y, int16_t sym, int16_t col, int16_t colEdges);
+	void beginSubcells();
+	void endSubcells(bool frameChanged);
+	void resolveSubcells();
+	uint16_t getVisibleColour(const CHAR_INFO& cell);
+	Point3D toLightSpace(const Point3D& point);
 	bool onSegment(const Point3D& p, const Point3D& q, const Point3D& r);
 	bool checkPointAndSegment(const Point3D& start, const Point3D& p, const Point3D& end);
 
@@ -381,11 +550,18 @@ public:
 	matrix4x4 makeRotationX(float fAngleRad);
 	matrix4x4 makeRotationY(float fAngleRad);
 	matrix4x4 makeRotationZ(float fAngleRad);
+	matrix4x4 makeRotationEuler(float angleX, float angleY, float angleZ, float scale = 1.0f);
+	quaternion makeQuaternionEuler(float angleX, float angleY, float angleZ);
+	quaternion slerp(const quaternion& q1, const quaternion& q2, float t);
+	matrix4x4 makeRotationQuaternion(const quaternion& q, float scale = 1.0f);
 	matrix4x4 makeScale(float x, float y, float z);
 	matrix4x4 makeTranslation(float x, float y, float z);
 	matrix4x4 makeProjection(float fFovDegrees, float fAspectRatio, float fNear, float fFar);
 	matrix4x4 makeProjectionIzometric();
 	matrix4x4 multiplyMatrix(matrix4x4& m1, matrix4x4& m2);
+	void transformVertices(const VertexBuffer& in, matrix4x4& m, VertexBuffer& out);
+	Bvh::Bounds transformBounds(const Bvh::Bounds& bounds, matrix4x4& m);
+	void projectVertices(VertexBuffer& v, float scaleX, float offsetX, float scaleY, float offsetY);
 };
 
 #endif 
@@ -0,0 +1,105 @@
+#include "HeadlessPresenter.h"
+#include <algorithm>
+#include <cstdio>
+#include <cwchar>
+
+HeadlessPresenter::HeadlessPresenter(const string& dumpPath)
+{
+	this->dumpPath = dumpPath;
+	width = height = 0;
+	frameCount = 0;
+	cellsPresented = 0;
+}
+
+HeadlessPresenter::~HeadlessPresenter()
+{
+	if (!dumpPath.empty() && frameCount > 0)
+	{
+		dumpToFile(dumpPath);
+	}
+}
+
+int16_t HeadlessPresenter::create(int16_t width, int16_t height, int16_t /*fontW*/, int16_t /*fontH*/, const wstring& title)
+{
+	this->width = width;
+	this->height = height;
+	this->title.reserve(256);
+	this->title = title;
+	cells.assign(width * height, CHAR_INFO());
+	frameDiff.reset(width, height);
+	//   -    
+	dirtyRuns.reserve(height * ((width + 1) / 2));
+	return 0;
+}
+
+void HeadlessPresenter::pollInput(int16_t* /*keyStates*/, bool* /*mouseStates*/, int16_t& /*mouseX*/, int16_t& /*mouseY*/, bool& inFocus)
+{
+	//  :  ,   
+	inFocus = true;
+}
+
+void HeadlessPresenter::present(const CHAR_INFO* buffer, int16_t width, int16_t /*height*/)
+{
+	lastFrame = chrono::steady_clock::now();
+	if (frameCount == 0)
+	{
+		firstFrame = lastFrame;
+	}
+	//    
+	cellsPresented += frameDiff.compute(buffer, dirtyRuns);
+	for (auto& run : dirtyRuns)
+	{
+		copy(buffer + run.y * width + run.x1, buffer + run.y * width + run.x2 + 1, cells.begin() + run.y * width + run.x1);
+	}
+	frameCount++;
+}
+
+void HeadlessPresenter::setTitle(const wstring& title)
+{
+	this->title = title;
+}
+
+int16_t HeadlessPresenter::error(const wchar_t* msg)
+{
+	fwprintf(stderr, L"ERROR: %ls\n", msg);
+	return 1;
+}
+
+bool HeadlessPresenter::dumpToFile(const string& path)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+
+	if (!file)
+	{
+		return false;
+	}
+
+	//   UTF-8,    hex
+	string line;
+	fprintf(file, "%d %d\n", width, height);
+	for (int16_t y = 0; y < height; y++)
+	{
+		line.clear();
+		for (int16_t x = 0; x < width; x++)
+		{
+			appendUtf8(line, cells[y * width + x].Char.UnicodeChar);
+		}
+		fprintf(file, "%s\n", line.c_str());
+	}
+	for (int16_t y = 0; y < height; y++)
+	{
+		for (int16_t x = 0; x < width; x++)
+		{
+			fprintf(file, "%02X", cells[y * width + x].Attributes & 0xFF);
+		}
+		fprintf(file, "\n");
+	}
+	fclose(file);
+	return true;
+}
+
+float HeadlessPresenter::getFramesPerSecond()
+{
+	chrono::duration<float> elapsed = lastFrame - firstFrame;
+	return (frameCount > 1 && elapsed.count() > 0.0f) ? (frameCount - 1) / elapsed.count() : 0.0f;
+}
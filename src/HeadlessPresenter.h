@@ -0,0 +1,53 @@
+#ifndef _HEADLESS_PRESENTER_H_
+#define _HEADLESS_PRESENTER_H_
+
+#include "Presenter.h"
+#include <chrono>
+#include <vector>
+
+//       
+class HeadlessPresenter : public Presenter
+{
+private:
+	vector<CHAR_INFO> cells;
+	int16_t width, height;
+	uint32_t frameCount;
+	uint64_t cellsPresented;
+	FrameDiff frameDiff;
+	vector<DirtyRun> dirtyRuns;
+	string dumpPath;
+	wstring title;
+	chrono::steady_clock::time_point firstFrame;
+	chrono::steady_clock::time_point lastFrame;
+
+public:
+	HeadlessPresenter(const string& dumpPath = "");
+	~HeadlessPresenter();
+
+	virtual int16_t create(int16_t width, int16_t height, int16_t fontW, int16_t fontH, const wstring& title) override;
+	virtual void pollInput(int16_t* keyStates, bool* mouseStates, int16_t& mouseX, int16_t& mouseY, bool& inFocus) override;
+	virtual void present(const CHAR_INFO* buffer, int16_t width, int16_t height) override;
+	virtual void setTitle(const wstring& title) override;
+	virtual int16_t error(const wchar_t* msg) override;
+	virtual bool isLossless() override
+	{
+		return true;
+	}
+
+	bool dumpToFile(const string& path);
+	const vector<CHAR_INFO>& getCells()
+	{
+		return cells;
+	}
+	uint32_t getFrameCount()
+	{
+		return frameCount;
+	}
+	uint64_t getCellsPresented()
+	{
+		return cellsPresented;
+	}
+	float getFramesPerSecond();
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+using namespace std;
+
+// ,      
+class MappedFile
+{
+private:
+	const char* fileData;
+	size_t fileSize;
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#else
+	int fileDescriptor;
+#endif
+
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool open(const string& path);
+	void close();
+	const char* data()
+	{
+		return fileData;
+	}
+	size_t size()
+	{
+		return fileSize;
+	}
+};
+
+#endif
@@ -0,0 +1,283 @@
+#include "Geometry.h"
+#include "MappedFile.h"
+#include <cstdio>
+
+namespace
+{
+	//   :  x[], y[], z[]  indices[]
+	struct BinaryMeshHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+	};
+
+	const char binaryMagic[4] = { 'K', 'G', 'K', 'M' };
+	const uint32_t binaryVersion = 1;
+
+	inline bool isSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	inline void skipSpaces(const char*& p, const char* end)
+	{
+		while (p < end && isSpace(*p))
+		{
+			p++;
+		}
+	}
+
+	inline void skipLine(const char*& p, const char* end)
+	{
+		while (p < end && *p != '\n')
+		{
+			p++;
+		}
+		if (p < end)
+		{
+			p++;
+		}
+	}
+
+	bool parseInt(const char*& p, const char* end, long& value)
+	{
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = (*p == '-');
+			p++;
+		}
+		if (p >= end || *p < '0' || *p > '9')
+		{
+			return false;
+		}
+		value = 0;
+		while (p < end && *p >= '0' && *p <= '9')
+		{
+			value = value * 10 + (*p - '0');
+			p++;
+		}
+		value = negative ? -value : value;
+		return true;
+	}
+
+	bool parseFloat(const char*& p, const char* end, float& value)
+	{
+		bool negative = false;
+		bool digits = false;
+		double mantissa = 0.0;
+
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = (*p == '-');
+			p++;
+		}
+		while (p < end && *p >= '0' && *p <= '9')
+		{
+			mantissa = mantissa * 10.0 + (*p - '0');
+			digits = true;
+			p++;
+		}
+		if (p < end && *p == '.')
+		{
+			double fraction = 0.1;
+			p++;
+			while (p < end && *p >= '0' && *p <= '9')
+			{
+				mantissa += (*p - '0') * fraction;
+				fraction *= 0.1;
+				digits = true;
+				p++;
+			}
+		}
+		if (!digits)
+		{
+			return false;
+		}
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			long exponent = 0;
+			p++;
+			if (!parseInt(p, end, exponent))
+			{
+				return false;
+			}
+			mantissa *= pow(10.0, static_cast<double>(exponent));
+		}
+		value = static_cast<float>(negative ? -mantissa : mantissa);
+		return true;
+	}
+}
+
+bool Geometry::loadMeshObj(const string& path, Mesh& mesh)
+{
+	MappedFile file;
+
+	if (!file.open(path))
+	{
+		return false;
+	}
+
+	const char* begin = file.data();
+	const char* end = begin + file.size();
+	const char* p = begin;
+
+	//        
+	size_t vertexLines = 0, faceLines = 0;
+	while (p < end)
+	{
+		if (p + 1 < end && p[1] == ' ')
+		{
+			vertexLines += (p[0] == 'v');
+			faceLines += (p[0] == 'f');
+		}
+		skipLine(p, end);
+	}
+
+	mesh = Mesh();
+	mesh.vertices.x.reserve(vertexLines);
+	mesh.vertices.y.reserve(vertexLines);
+	mesh.vertices.z.reserve(vertexLines);
+	mesh.vertices.w.reserve(vertexLines);
+	mesh.indices.reserve(faceLines * 3);
+
+	p = begin;
+	while (p < end)
+	{
+		skipSpaces(p, end);
+		if (p + 1 < end && p[0] == 'v' && isSpace(p[1]))
+		{
+			float x = 0.0f, y = 0.0f, z = 0.0f;
+			p += 2;
+			skipSpaces(p, end);
+			bool ok = parseFloat(p, end, x);
+			skipSpaces(p, end);
+			ok = ok && parseFloat(p, end, y);
+			skipSpaces(p, end);
+			ok = ok && parseFloat(p, end, z);
+			if (!ok)
+			{
+				return false;
+			}
+			mesh.vertices.x.push_back(x);
+			mesh.vertices.y.push_back(y);
+			mesh.vertices.z.push_back(z);
+			mesh.vertices.w.push_back(1.0f);
+		}
+		else if (p + 1 < end && p[0] == 'f' && isSpace(p[1]))
+		{
+			//    
+			long vertexCount = static_cast<long>(mesh.vertices.size());
+			uint32_t first = 0, previous = 0;
+			int16_t corner = 0;
+
+			p += 2;
+			skipSpaces(p, end);
+			while (p < end && *p != '\n' && *p != '#')
+			{
+				long index = 0;
+				if (!parseInt(p, end, index))
+				{
+					return false;
+				}
+				index = (index < 0) ? vertexCount + index : index - 1;
+				if (index < 0 || index >= vertexCount)
+				{
+					return false;
+				}
+				//     
+				while (p < end && !isSpace(*p) && *p != '\n')
+				{
+					p++;
+				}
+				skipSpaces(p, end);
+
+				uint32_t current = static_cast<uint32_t>(index);
+				if (corner == 0)
+				{
+					first = current;
+				}
+				else if (corner >= 2)
+				{
+					mesh.indices.push_back(first);
+					mesh.indices.push_back(previous);
+					mesh.indices.push_back(current);
+				}
+				previous = current;
+				corner++;
+			}
+		}
+		skipLine(p, end);
+	}
+
+	return !mesh.indices.empty();
+}
+
+bool Geometry::loadMeshBinary(const string& path, Mesh& mesh)
+{
+	MappedFile file;
+	BinaryMeshHeader header;
+
+	if (!file.open(path) || file.size() < sizeof(header))
+	{
+		return false;
+	}
+	memcpy(&header, file.data(), sizeof(header));
+	if (memcmp(header.magic, binaryMagic, sizeof(binaryMagic)) || header.version != binaryVersion)
+	{
+		return false;
+	}
+
+	size_t expected = sizeof(header) + sizeof(float) * 3 * static_cast<size_t>(header.vertexCount)
+		+ sizeof(uint32_t) * static_cast<size_t>(header.indexCount);
+	if (file.size() < expected || header.indexCount % 3)
+	{
+		return false;
+	}
+
+	const char* p = file.data() + sizeof(header);
+	size_t columnSize = sizeof(float) * header.vertexCount;
+
+	mesh = Mesh();
+	mesh.vertices.resize(header.vertexCount);
+	memcpy(mesh.vertices.x.data(), p, columnSize);
+	memcpy(mesh.vertices.y.data(), p + columnSize, columnSize);
+	memcpy(mesh.vertices.z.data(), p + 2 * columnSize, columnSize);
+	mesh.indices.resize(header.indexCount);
+	memcpy(mesh.indices.data(), p + 3 * columnSize, sizeof(uint32_t) * header.indexCount);
+
+	for (uint32_t index : mesh.indices)
+	{
+		if (index >= header.vertexCount)
+		{
+			return false;
+		}
+	}
+	return !mesh.indices.empty();
+}
+
+bool Geometry::saveMeshBinary(const string& path, const Mesh& mesh)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+
+	if (!file)
+	{
+		return false;
+	}
+
+	BinaryMeshHeader header;
+	memcpy(header.magic, binaryMagic, sizeof(binaryMagic));
+	header.version = binaryVersion;
+	header.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+	header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	ok = ok && fwrite(mesh.vertices.x.data(), sizeof(float), header.vertexCount, file) == header.vertexCount;
+	ok = ok && fwrite(mesh.vertices.y.data(), sizeof(float), header.vertexCount, file) == header.vertexCount;
+	ok = ok && fwrite(mesh.vertices.z.data(), sizeof(float), header.vertexCount, file) == header.vertexCount;
+	ok = ok && fwrite(mesh.indices.data(), sizeof(uint32_t), header.indexCount, file) == header.indexCount;
+	fclose(file);
+	return ok;
+}
@@ -0,0 +1,405 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cmath>
+
+void MeshSimplifier::Quadric::reset()
+{
+	fill(m, m + 10, 0.0);
+}
+
+void MeshSimplifier::Quadric::addPlane(double a, double b, double c, double d)
+{
+	m[0] += a * a; m[1] += a * b; m[2] += a * c; m[3] += a * d;
+	m[4] += b * b; m[5] += b * c; m[6] += b * d;
+	m[7] += c * c; m[8] += c * d;
+	m[9] += d * d;
+}
+
+void MeshSimplifier::Quadric::add(const Quadric& obj)
+{
+	for (int16_t i = 0; i < 10; i++)
+	{
+		m[i] += obj.m[i];
+	}
+}
+
+double MeshSimplifier::Quadric::det(int16_t a11, int16_t a12, int16_t a13, int16_t a21, int16_t a22, int16_t a23,
+	int16_t a31, int16_t a32, int16_t a33) const
+{
+	return m[a11] * m[a22] * m[a33] + m[a13] * m[a21] * m[a32] + m[a12] * m[a23] * m[a31]
+		- m[a13] * m[a22] * m[a31] - m[a11] * m[a23] * m[a32] - m[a12] * m[a21] * m[a33];
+}
+
+double MeshSimplifier::Quadric::error(double x, double y, double z) const
+{
+	return m[0] * x * x + 2.0 * m[1] * x * y + 2.0 * m[2] * x * z + 2.0 * m[3] * x
+		+ m[4] * y * y + 2.0 * m[5] * y * z + 2.0 * m[6] * y
+		+ m[7] * z * z + 2.0 * m[8] * z + m[9];
+}
+
+double MeshSimplifier::calculateError(uint32_t i0, uint32_t i1, double result[3])
+{
+	Quadric q = vertices[i0].q;
+	q.add(vertices[i1].q);
+	bool border = vertices[i0].border && vertices[i1].border;
+
+	//   ,        
+	double det = q.det(0, 1, 2, 1, 4, 5, 2, 5, 7);
+	if (det != 0.0 && !border)
+	{
+		result[0] = -1.0 / det * q.det(1, 2, 3, 4, 5, 6, 5, 7, 8);
+		result[1] = 1.0 / det * q.det(0, 2, 3, 1, 5, 6, 2, 7, 8);
+		result[2] = -1.0 / det * q.det(0, 1, 3, 1, 4, 6, 2, 5, 8);
+		return q.error(result[0], result[1], result[2]);
+	}
+
+	//        
+	const double* p1 = vertices[i0].p;
+	const double* p2 = vertices[i1].p;
+	double p3[3] = { (p1[0] + p2[0]) * 0.5, (p1[1] + p2[1]) * 0.5, (p1[2] + p2[2]) * 0.5 };
+	double error1 = q.error(p1[0], p1[1], p1[2]);
+	double error2 = q.error(p2[0], p2[1], p2[2]);
+	double error3 = q.error(p3[0], p3[1], p3[2]);
+	double error = min(error1, min(error2, error3));
+	const double* best = (error == error1) ? p1 : ((error == error2) ? p2 : p3);
+	copy(best, best + 3, result);
+	return error;
+}
+
+bool MeshSimplifier::flipped(const double p[3], uint32_t i1, const Vertex& v0, vector<uint8_t>& deleted)
+{
+	for (uint32_t k = 0; k < v0.refCount; k++)
+	{
+		const Ref& ref = refs[v0.refStart + k];
+		Triangle& t = triangles[ref.triangle];
+		if (t.deleted)
+		{
+			continue;
+		}
+
+		uint32_t id1 = t.v[(ref.corner + 1) % 3];
+		uint32_t id2 = t.v[(ref.corner + 2) % 3];
+		//     
+		if (id1 == i1 || id2 == i1)
+		{
+			deleted[k] = 1;
+			continue;
+		}
+
+		double d1[3], d2[3];
+		for (int16_t i = 0; i < 3; i++)
+		{
+			d1[i] = vertices[id1].p[i] - p[i];
+			d2[i] = vertices[id2].p[i] - p[i];
+		}
+		double l1 = sqrt(d1[0] * d1[0] + d1[1] * d1[1] + d1[2] * d1[2]);
+		double l2 = sqrt(d2[0] * d2[0] + d2[1] * d2[1] + d2[2] * d2[2]);
+		if (l1 == 0.0 || l2 == 0.0)
+		{
+			return true;
+		}
+		for (int16_t i = 0; i < 3; i++)
+		{
+			d1[i] /= l1;
+			d2[i] /= l2;
+		}
+		if (fabs(d1[0] * d2[0] + d1[1] * d2[1] + d1[2] * d2[2]) > 0.999)
+		{
+			return true;
+		}
+
+		//      
+		double n[3] = { d1[1] * d2[2] - d1[2] * d2[1], d1[2] * d2[0] - d1[0] * d2[2], d1[0] * d2[1] - d1[1] * d2[0] };
+		double ln = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		deleted[k] = 0;
+		if ((n[0] * t.n[0] + n[1] * t.n[1] + n[2] * t.n[2]) / ln < 0.2)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void MeshSimplifier::updateTriangles(uint32_t i0, const Vertex& v, const vector<uint8_t>& deleted, size_t& deletedTriangles)
+{
+	double p[3];
+	for (uint32_t k = 0; k < v.refCount; k++)
+	{
+		Ref ref = refs[v.refStart + k];
+		Triangle& t = triangles[ref.triangle];
+		if (t.deleted)
+		{
+			continue;
+		}
+		if (deleted[k])
+		{
+			t.deleted = true;
+			deletedTriangles++;
+			continue;
+		}
+
+		t.v[ref.corner] = i0;
+		t.dirty = true;
+		t.err[0] = calculateError(t.v[0], t.v[1], p);
+		t.err[1] = calculateError(t.v[1], t.v[2], p);
+		t.err[2] = calculateError(t.v[2], t.v[0], p);
+		t.err[3] = min(t.err[0], min(t.err[1], t.err[2]));
+		refs.push_back(ref);
+	}
+}
+
+void MeshSimplifier::updateMesh(int16_t iteration)
+{
+	if (iteration > 0)
+	{
+		triangles.erase(remove_if(triangles.begin(), triangles.end(), [](const Triangle& t) { return t.deleted; }), triangles.end());
+	}
+
+	//     
+	for (auto& v : vertices)
+	{
+		v.refStart = 0;
+		v.refCount = 0;
+	}
+	for (auto& t : triangles)
+	{
+		for (int16_t j = 0; j < 3; j++)
+		{
+			vertices[t.v[j]].refCount++;
+		}
+	}
+	uint32_t start = 0;
+	for (auto& v : vertices)
+	{
+		v.refStart = start;
+		start += v.refCount;
+		v.refCount = 0;
+	}
+	refs.resize(triangles.size() * 3);
+	for (uint32_t i = 0; i < triangles.size(); i++)
+	{
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			Vertex& v = vertices[triangles[i].v[j]];
+			refs[v.refStart + v.refCount] = { i, j };
+			v.refCount++;
+		}
+	}
+
+	if (iteration > 0)
+	{
+		return;
+	}
+
+	//   ,        
+	vector<uint32_t> neighbours, counts;
+	for (auto& v : vertices)
+	{
+		v.border = false;
+	}
+	for (auto& v : vertices)
+	{
+		neighbours.clear();
+		counts.clear();
+		for (uint32_t k = 0; k < v.refCount; k++)
+		{
+			const Triangle& t = triangles[refs[v.refStart + k].triangle];
+			for (int16_t j = 0; j < 3; j++)
+			{
+				auto it = find(neighbours.begin(), neighbours.end(), t.v[j]);
+				if (it == neighbours.end())
+				{
+					neighbours.push_back(t.v[j]);
+					counts.push_back(1);
+				}
+				else
+				{
+					counts[it - neighbours.begin()]++;
+				}
+			}
+		}
+		for (size_t j = 0; j < neighbours.size(); j++)
+		{
+			if (counts[j] == 1)
+			{
+				vertices[neighbours[j]].border = true;
+			}
+		}
+	}
+
+	//      
+	for (auto& v : vertices)
+	{
+		v.q.reset();
+	}
+	for (auto& t : triangles)
+	{
+		const double* p0 = vertices[t.v[0]].p;
+		const double* p1 = vertices[t.v[1]].p;
+		const double* p2 = vertices[t.v[2]].p;
+		double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+		double n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+		double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (length > 0.0)
+		{
+			n[0] /= length;
+			n[1] /= length;
+			n[2] /= length;
+		}
+		copy(n, n + 3, t.n);
+		double d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+		for (int16_t j = 0; j < 3; j++)
+		{
+			vertices[t.v[j]].q.addPlane(n[0], n[1], n[2], d);
+		}
+	}
+
+	double p[3];
+	for (auto& t : triangles)
+	{
+		for (int16_t j = 0; j < 3; j++)
+		{
+			t.err[j] = calculateError(t.v[j], t.v[(j + 1) % 3], p);
+		}
+		t.err[3] = min(t.err[0], min(t.err[1], t.err[2]));
+	}
+}
+
+void MeshSimplifier::compactMesh()
+{
+	triangles.erase(remove_if(triangles.begin(), triangles.end(), [](const Triangle& t) { return t.deleted; }), triangles.end());
+
+	//   ,  
+	vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+	vector<Vertex> used;
+	used.reserve(vertices.size());
+	for (auto& t : triangles)
+	{
+		for (int16_t j = 0; j < 3; j++)
+		{
+			if (remap[t.v[j]] == UINT32_MAX)
+			{
+				remap[t.v[j]] = static_cast<uint32_t>(used.size());
+				used.push_back(vertices[t.v[j]]);
+			}
+			t.v[j] = remap[t.v[j]];
+		}
+	}
+	vertices.swap(used);
+}
+
+bool MeshSimplifier::simplify(const Geometry::VertexBuffer& sourceVertices, const vector<uint32_t>& sourceIndices, size_t targetTriangles,
+	Geometry::VertexBuffer& outVertices, vector<uint32_t>& outIndices)
+{
+	vertices.resize(sourceVertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		vertices[i].p[0] = sourceVertices.x[i];
+		vertices[i].p[1] = sourceVertices.y[i];
+		vertices[i].p[2] = sourceVertices.z[i];
+	}
+	triangles.resize(sourceIndices.size() / 3);
+	for (size_t i = 0; i < triangles.size(); i++)
+	{
+		Triangle& t = triangles[i];
+		copy(&sourceIndices[i * 3], &sourceIndices[i * 3] + 3, t.v);
+		t.deleted = false;
+		t.dirty = false;
+	}
+
+	size_t triangleCount = triangles.size();
+	size_t deletedTriangles = 0;
+	double p[3];
+
+	//      ,     
+	for (int16_t iteration = 0; iteration < 100; iteration++)
+	{
+		if (triangleCount - deletedTriangles <= targetTriangles)
+		{
+			break;
+		}
+		if (iteration % 5 == 0)
+		{
+			updateMesh(iteration);
+		}
+		for (auto& t : triangles)
+		{
+			t.dirty = false;
+		}
+
+		double threshold = 1e-9 * pow(iteration + 3.0, 7.0);
+		for (size_t i = 0; i < triangles.size() && triangleCount - deletedTriangles > targetTriangles; i++)
+		{
+			Triangle& t = triangles[i];
+			if (t.err[3] > threshold || t.deleted || t.dirty)
+			{
+				continue;
+			}
+
+			for (int16_t j = 0; j < 3; j++)
+			{
+				if (t.err[j] > threshold)
+				{
+					continue;
+				}
+				uint32_t i0 = t.v[j];
+				uint32_t i1 = t.v[(j + 1) % 3];
+				Vertex& v0 = vertices[i0];
+				Vertex& v1 = vertices[i1];
+				if (v0.border != v1.border)
+				{
+					continue;
+				}
+
+				calculateError(i0, i1, p);
+				deleted0.assign(v0.refCount, 0);
+				deleted1.assign(v1.refCount, 0);
+				if (flipped(p, i1, v0, deleted0) || flipped(p, i0, v1, deleted1))
+				{
+					continue;
+				}
+
+				//  v1   v0,     v0
+				copy(p, p + 3, v0.p);
+				v0.q.add(v1.q);
+				uint32_t refStart = static_cast<uint32_t>(refs.size());
+				updateTriangles(i0, v0, deleted0, deletedTriangles);
+				updateTriangles(i0, v1, deleted1, deletedTriangles);
+				uint32_t refCount = static_cast<uint32_t>(refs.size()) - refStart;
+
+				//      ,  
+				if (refCount <= v0.refCount)
+				{
+					if (refCount)
+					{
+						copy(refs.begin() + refStart, refs.begin() + refStart + refCount, refs.begin() + v0.refStart);
+					}
+					refs.resize(refStart);
+				}
+				else
+				{
+					v0.refStart = refStart;
+				}
+				v0.refCount = refCount;
+				break;
+			}
+		}
+	}
+	compactMesh();
+
+	outVertices.resize(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		outVertices.x[i] = static_cast<float>(vertices[i].p[0]);
+		outVertices.y[i] = static_cast<float>(vertices[i].p[1]);
+		outVertices.z[i] = static_cast<float>(vertices[i].p[2]);
+		outVertices.w[i] = 1.0f;
+	}
+	outIndices.resize(triangles.size() * 3);
+	for (size_t i = 0; i < triangles.size(); i++)
+	{
+		copy(triangles[i].v, triangles[i].v + 3, &outIndices[i * 3]);
+	}
+	return triangles.size() < sourceIndices.size() / 3;
+}
@@ -0,0 +1,61 @@
+#ifndef _MESH_SIMPLIFIER_H_
+#define _MESH_SIMPLIFIER_H_
+
+#include "Geometry.h"
+
+//        
+class MeshSimplifier
+{
+private:
+	//   4x4    
+	struct Quadric
+	{
+		double m[10];
+
+		void reset();
+		void addPlane(double a, double b, double c, double d);
+		void add(const Quadric& obj);
+		double det(int16_t a11, int16_t a12, int16_t a13, int16_t a21, int16_t a22, int16_t a23,
+			int16_t a31, int16_t a32, int16_t a33) const;
+		double error(double x, double y, double z) const;
+	};
+
+	struct Vertex
+	{
+		double p[3];
+		Quadric q;
+		uint32_t refStart, refCount;
+		bool border;
+	};
+
+	struct Triangle
+	{
+		uint32_t v[3];
+		double err[4];
+		double n[3];
+		bool deleted, dirty;
+	};
+
+	//         
+	struct Ref
+	{
+		uint32_t triangle, corner;
+	};
+
+	vector<Vertex> vertices;
+	vector<Triangle> triangles;
+	vector<Ref> refs;
+	vector<uint8_t> deleted0, deleted1;
+
+	double calculateError(uint32_t i0, uint32_t i1, double result[3]);
+	bool flipped(const double p[3], uint32_t i1, const Vertex& v0, vector<uint8_t>& deleted);
+	void updateTriangles(uint32_t i0, const Vertex& v, const vector<uint8_t>& deleted, size_t& deletedTriangles);
+	void updateMesh(int16_t iteration);
+	void compactMesh();
+
+public:
+	bool simplify(const Geometry::VertexBuffer& sourceVertices, const vector<uint32_t>& sourceIndices, size_t targetTriangles,
+		Geometry::VertexBuffer& outVertices, vector<uint32_t>& outIndices);
+};
+
+#endif
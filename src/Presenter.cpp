@@ -0,0 +1,113 @@
+#include "Presenter.h"
+#include "HeadlessPresenter.h"
+#ifdef _WIN32
+#include "ConsolePresenter.h"
+#else
+#include "TerminalPresenter.h"
+#include <unistd.h>
+#endif
+
+Presenter* createDefaultPresenter()
+{
+#ifdef _WIN32
+	return new ConsolePresenter();
+#else
+	if (isatty(STDOUT_FILENO))
+	{
+		return new TerminalPresenter();
+	}
+	return new HeadlessPresenter();
+#endif
+}
+
+void appendUtf8(string& out, wchar_t c)
+{
+	uint32_t code = static_cast<uint32_t>(c);
+
+	if (code == 0)
+	{
+		code = ' ';
+	}
+	if (code < 0x80)
+	{
+		out += static_cast<char>(code);
+	}
+	else if (code < 0x800)
+	{
+		out += static_cast<char>(0xC0 | (code >> 6));
+		out += static_cast<char>(0x80 | (code & 0x3F));
+	}
+	else
+	{
+		out += static_cast<char>(0xE0 | (code >> 12));
+		out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+		out += static_cast<char>(0x80 | (code & 0x3F));
+	}
+}
+
+FrameDiff::FrameDiff()
+{
+	width = height = 0;
+	valid = false;
+}
+
+void FrameDiff::reset(int16_t width, int16_t height)
+{
+	this->width = width;
+	this->height = height;
+	previous.assign(width * height, CHAR_INFO());
+	valid = false;
+}
+
+void FrameDiff::invalidate()
+{
+	valid = false;
+}
+
+size_t FrameDiff::compute(const CHAR_INFO* buffer, vector<DirtyRun>& runs, int16_t mergeGap)
+{
+	auto differs = [](const CHAR_INFO& a, const CHAR_INFO& b)
+	{
+		return a.Char.UnicodeChar != b.Char.UnicodeChar || a.Attributes != b.Attributes;
+	};
+	size_t changed = 0;
+
+	runs.clear();
+	for (int16_t y = 0; y < height; y++)
+	{
+		const CHAR_INFO* row = &buffer[y * width];
+		CHAR_INFO* oldRow = &previous[y * width];
+		int16_t x = 0;
+
+		while (x < width)
+		{
+			if (valid && !differs(row[x], oldRow[x]))
+			{
+				x++;
+				continue;
+			}
+
+			// ,   , 
+			DirtyRun run = { y, x, x };
+			int16_t gap = 0;
+			while (x < width && gap <= mergeGap)
+			{
+				if (!valid || differs(row[x], oldRow[x]))
+				{
+					oldRow[x] = row[x];
+					run.x2 = x;
+					changed++;
+					gap = 0;
+				}
+				else
+				{
+					gap++;
+				}
+				x++;
+			}
+			runs.push_back(run);
+		}
+	}
+	valid = true;
+	return changed;
+}
@@ -0,0 +1,85 @@
+#ifndef _PRESENTER_H_
+#define _PRESENTER_H_
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cstdint>
+
+//   Win32   
+struct CHAR_INFO
+{
+	union
+	{
+		wchar_t UnicodeChar;
+		char AsciiChar;
+	} Char;
+	uint16_t Attributes;
+};
+
+#define VK_LBUTTON 0x01
+#define VK_ESCAPE 0x1B
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//     [x1, x2]
+struct DirtyRun
+{
+	int16_t y, x1, x2;
+};
+
+//     
+class FrameDiff
+{
+private:
+	vector<CHAR_INFO> previous;
+	int16_t width, height;
+	bool valid;
+
+public:
+	FrameDiff();
+
+	void reset(int16_t width, int16_t height);
+	void invalidate();
+	size_t compute(const CHAR_INFO* buffer, vector<DirtyRun>& runs, int16_t mergeGap = 0);
+};
+
+//     
+class Presenter
+{
+public:
+	virtual ~Presenter() {}
+
+	virtual int16_t create(int16_t width, int16_t height, int16_t fontW, int16_t fontH, const wstring& title) = 0;
+	virtual void pollInput(int16_t* keyStates, bool* mouseStates, int16_t& mouseX, int16_t& mouseY, bool& inFocus) = 0;
+	virtual void present(const CHAR_INFO* buffer, int16_t width, int16_t height) = 0;
+	virtual void setTitle(const wstring& title) = 0;
+	virtual int16_t error(const wchar_t* msg) = 0;
+	virtual bool isOpen()
+	{
+		return true;
+	}
+	//    ,     
+	virtual bool isLossless()
+	{
+		return false;
+	}
+	//    , true     
+	virtual bool waitForInput(uint32_t timeoutMs)
+	{
+		this_thread::sleep_for(chrono::milliseconds(timeoutMs));
+		return false;
+	}
+};
+
+Presenter* createDefaultPresenter();
+void appendUtf8(string& out, wchar_t c);
+
+#endif
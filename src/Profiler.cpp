@@ -0,0 +1,157 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdio>
+
+Profiler::Profiler(size_t capacity)
+{
+	enabled = false;
+	this->capacity = capacity;
+	nextSample = 0;
+	sampleCount = 0;
+	frameCount = 0;
+
+	for (int16_t i = 0; i < STAGE_COUNT; i++)
+	{
+		current[i] = 0;
+		samples[i].assign(capacity, 0.0f);
+	}
+}
+
+const char* Profiler::stageName(PROFILE_STAGE stage)
+{
+	static const char* names[STAGE_COUNT] = { "input", "transform", "sort", "shadow", "paint", "fill", "present", "frame" };
+	return names[stage];
+}
+
+void Profiler::endFrame()
+{
+	//     :        
+	if (!enabled)
+	{
+		for (int16_t i = 0; i < STAGE_COUNT; i++)
+		{
+			current[i].store(0, memory_order_relaxed);
+		}
+		return;
+	}
+
+	//         
+	for (int16_t i = 0; i < STAGE_COUNT; i++)
+	{
+		samples[i][nextSample] = current[i].exchange(0, memory_order_relaxed) / 1000000.0f;
+	}
+	nextSample = (nextSample + 1) % capacity;
+	sampleCount = min(sampleCount + 1, capacity);
+	frameCount++;
+}
+
+Profiler::StageStats Profiler::getStats(PROFILE_STAGE stage)
+{
+	StageStats stats = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	if (sampleCount == 0)
+	{
+		return stats;
+	}
+
+	vector<float> sorted(samples[stage].begin(), samples[stage].begin() + sampleCount);
+	sort(sorted.begin(), sorted.end());
+
+	float sum = 0.0f;
+	for (float value : sorted)
+	{
+		sum += value;
+	}
+	stats.mean = sum / sampleCount;
+	stats.p50 = sorted[(sampleCount - 1) * 50 / 100];
+	stats.p99 = sorted[(sampleCount - 1) * 99 / 100];
+	stats.max = sorted.back();
+	return stats;
+}
+
+vector<uint32_t> Profiler::getHistogram(PROFILE_STAGE stage, float bucketMs, size_t buckets)
+{
+	vector<uint32_t> histogram(buckets, 0);
+
+	//      
+	for (size_t i = 0; i < sampleCount; i++)
+	{
+		size_t bucket = static_cast<size_t>(samples[stage][i] / bucketMs);
+		histogram[min(bucket, buckets - 1)]++;
+	}
+	return histogram;
+}
+
+bool Profiler::exportCsv(const string& path)
+{
+	FILE* file = fopen(path.c_str(), "w");
+
+	if (!file)
+	{
+		return false;
+	}
+
+	fprintf(file, "frame");
+	for (int16_t i = 0; i < STAGE_COUNT; i++)
+	{
+		fprintf(file, ",%s_ms", stageName(static_cast<PROFILE_STAGE>(i)));
+	}
+	fprintf(file, "\n");
+
+	//     
+	size_t first = (sampleCount < capacity) ? 0 : nextSample;
+	for (size_t n = 0; n < sampleCount; n++)
+	{
+		size_t index = (first + n) % capacity;
+		fprintf(file, "%llu", static_cast<unsigned long long>(frameCount - sampleCount + n));
+		for (int16_t i = 0; i < STAGE_COUNT; i++)
+		{
+			fprintf(file, ",%.4f", samples[i][index]);
+		}
+		fprintf(file, "\n");
+	}
+	fclose(file);
+	return true;
+}
+
+bool Profiler::exportJson(const string& path)
+{
+	FILE* file = fopen(path.c_str(), "w");
+
+	if (!file)
+	{
+		return false;
+	}
+
+	fprintf(file, "{\n  \"frames\": %llu,\n  \"window\": %zu,\n  \"stages\": {\n",
+		static_cast<unsigned long long>(frameCount), sampleCount);
+	for (int16_t i = 0; i < STAGE_COUNT; i++)
+	{
+		PROFILE_STAGE stage = static_cast<PROFILE_STAGE>(i);
+		StageStats stats = getStats(stage);
+		fprintf(file, "    \"%s\": { \"mean_ms\": %.4f, \"p50_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f, \"histogram\": [",
+			stageName(stage), stats.mean, stats.p50, stats.p99, stats.max);
+
+		//      HISTOGRAM_BUCKET_MS,    
+		vector<uint32_t> histogram = getHistogram(stage, HISTOGRAM_BUCKET_MS, HISTOGRAM_BUCKETS);
+		for (size_t b = 0; b < histogram.size(); b++)
+		{
+			fprintf(file, "%s%u", b ? ", " : "", histogram[b]);
+		}
+		fprintf(file, "] }%s\n", (i + 1 < STAGE_COUNT) ? "," : "");
+	}
+	fprintf(file, "  },\n  \"histogram_bucket_ms\": %.2f\n}\n", HISTOGRAM_BUCKET_MS);
+	fclose(file);
+	return true;
+}
+
+bool Profiler::exportFile(const string& path)
+{
+	size_t dot = path.find_last_of('.');
+
+	if (dot != string::npos && path.substr(dot) == ".json")
+	{
+		return exportJson(path);
+	}
+	return exportCsv(path);
+}
@@ -0,0 +1,109 @@
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//      JSON:     
+constexpr float HISTOGRAM_BUCKET_MS = 0.5f;
+constexpr size_t HISTOGRAM_BUCKETS = 64;
+
+enum PROFILE_STAGE
+{
+	STAGE_INPUT,
+	STAGE_TRANSFORM,
+	STAGE_SORT,
+	STAGE_SHADOW,
+	STAGE_PAINT,
+	STAGE_FILL,
+	STAGE_PRESENT,
+	STAGE_FRAME,
+	STAGE_COUNT,
+};
+
+//         
+class Profiler
+{
+public:
+	struct StageStats
+	{
+		float mean, p50, p99, max;
+	};
+
+private:
+	bool enabled;
+	atomic<int64_t> current[STAGE_COUNT];
+	vector<float> samples[STAGE_COUNT];
+	size_t capacity;
+	size_t nextSample;
+	size_t sampleCount;
+	uint64_t frameCount;
+
+public:
+	Profiler(size_t capacity = 1024);
+
+	static const char* stageName(PROFILE_STAGE stage);
+
+	void setEnabled(bool value)
+	{
+		enabled = value;
+	}
+	bool isEnabled()
+	{
+		return enabled;
+	}
+	void addTime(PROFILE_STAGE stage, int64_t nanoseconds)
+	{
+		if (!enabled)
+		{
+			return;
+		}
+		current[stage].fetch_add(nanoseconds, memory_order_relaxed);
+	}
+	void endFrame();
+	size_t getSampleCount()
+	{
+		return sampleCount;
+	}
+	StageStats getStats(PROFILE_STAGE stage);
+	vector<uint32_t> getHistogram(PROFILE_STAGE stage, float bucketMs, size_t buckets);
+	bool exportCsv(const string& path);
+	bool exportJson(const string& path);
+	bool exportFile(const string& path);
+};
+
+//    
+class ScopedTimer
+{
+private:
+	Profiler& profiler;
+	PROFILE_STAGE stage;
+	chrono::steady_clock::time_point start;
+
+public:
+	ScopedTimer(Profiler& profiler, PROFILE_STAGE stage) : profiler(profiler), stage(stage)
+	{
+		if (profiler.isEnabled())
+		{
+			start = chrono::steady_clock::now();
+		}
+	}
+	~ScopedTimer()
+	{
+		if (profiler.isEnabled())
+		{
+			profiler.addTime(stage, chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+		}
+	}
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(profiler, stage) ScopedTimer PROFILE_CONCAT(scopedTimer, __LINE__)(profiler, stage)
+
+#endif
@@ -0,0 +1,94 @@
+#include "SceneGraph.h"
+
+SceneGraph::SceneGraph()
+{
+	anyDirty = false;
+	recomputed = 0;
+}
+
+uint32_t SceneGraph::addNode(uint32_t parent, const Geometry::matrix4x4& local)
+{
+	Node node;
+	node.parent = (parent < nodes.size()) ? parent : NO_PARENT;
+	node.local = local;
+	node.dirty = true;
+	node.version = 0;
+	node.parentVersion = 0;
+	nodes.push_back(move(node));
+	anyDirty = true;
+	return static_cast<uint32_t>(nodes.size() - 1);
+}
+
+void SceneGraph::setLocal(uint32_t index, const Geometry::matrix4x4& local)
+{
+	nodes[index].local = local;
+	nodes[index].dirty = true;
+	anyDirty = true;
+}
+
+void SceneGraph::attachMesh(uint32_t index, uint32_t mesh)
+{
+	nodes[index].meshes.push_back(mesh);
+}
+
+void SceneGraph::updateNode(uint32_t index)
+{
+	Node& node = nodes[index];
+	if (node.parent == NO_PARENT)
+	{
+		if (node.dirty)
+		{
+			node.world = node.local;
+			node.version++;
+			node.dirty = false;
+			recomputed++;
+		}
+		return;
+	}
+
+	Node& parent = nodes[node.parent];
+	if (node.dirty || node.parentVersion != parent.version)
+	{
+		node.world = node.local * parent.world;
+		node.parentVersion = parent.version;
+		node.version++;
+		node.dirty = false;
+		recomputed++;
+	}
+}
+
+void SceneGraph::updateChain(uint32_t index)
+{
+	if (nodes[index].parent != NO_PARENT)
+	{
+		updateChain(nodes[index].parent);
+	}
+	updateNode(index);
+}
+
+const Geometry::matrix4x4& SceneGraph::getWorld(uint32_t index)
+{
+	//     ,   
+	if (anyDirty)
+	{
+		updateChain(index);
+	}
+	return nodes[index].world;
+}
+
+size_t SceneGraph::update()
+{
+	recomputed = 0;
+	if (!anyDirty)
+	{
+		return 0;
+	}
+
+	//    ,     
+	for (uint32_t i = 0; i < nodes.size(); i++)
+	{
+		updateNode(i);
+	}
+	anyDirty = false;
+	return recomputed;
+}
@@ -0,0 +1,53 @@
+#ifndef _SCENE_GRAPH_H_
+#define _SCENE_GRAPH_H_
+
+#include "Geometry.h"
+
+//         
+class SceneGraph
+{
+public:
+	static const uint32_t NO_PARENT = UINT32_MAX;
+
+	//     ,        
+	struct Node
+	{
+		uint32_t parent;
+		Geometry::matrix4x4 local;
+		Geometry::matrix4x4 world;
+		//   ,       
+		bool dirty;
+		uint32_t version;
+		uint32_t parentVersion;
+		vector<uint32_t> meshes;
+	};
+
+private:
+	vector<Node> nodes;
+	bool anyDirty;
+	size_t recomputed;
+
+	void updateNode(uint32_t index);
+	void updateChain(uint32_t index);
+
+public:
+	SceneGraph();
+
+	uint32_t addNode(uint32_t parent, const Geometry::matrix4x4& local);
+	void setLocal(uint32_t index, const Geometry::matrix4x4& local);
+	void attachMesh(uint32_t index, uint32_t mesh);
+
+	const Geometry::matrix4x4& getWorld(uint32_t index);
+	size_t update();
+
+	const Node& getNode(uint32_t index)
+	{
+		return nodes[index];
+	}
+	size_t size()
+	{
+		return nodes.size();
+	}
+};
+
+#endif
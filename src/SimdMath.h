@@ -0,0 +1,201 @@
+#ifndef _SIMD_MATH_H_
+#define _SIMD_MATH_H_
+
+#include <cstddef>
+
+//     , GEOMETRY_NO_SIMD  
+#if !defined(GEOMETRY_NO_SIMD)
+#if defined(__AVX__)
+#define GEOMETRY_SIMD_AVX
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GEOMETRY_SIMD_SSE
+#endif
+#endif
+
+#ifdef GEOMETRY_SIMD_SSE
+#include <immintrin.h>
+#endif
+
+//  4x4  ,   16 ; -  
+inline void simdMultiplyMatrix(const float a[4][4], const float b[4][4], float out[4][4])
+{
+#ifdef GEOMETRY_SIMD_SSE
+	__m128 b0 = _mm_load_ps(b[0]);
+	__m128 b1 = _mm_load_ps(b[1]);
+	__m128 b2 = _mm_load_ps(b[2]);
+	__m128 b3 = _mm_load_ps(b[3]);
+
+	for (int r = 0; r < 4; r++)
+	{
+		__m128 row = _mm_mul_ps(_mm_set1_ps(a[r][0]), b0);
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[r][1]), b1));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[r][2]), b2));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[r][3]), b3));
+		_mm_store_ps(out[r], row);
+	}
+#else
+	float result[4][4];
+	for (int c = 0; c < 4; c++)
+	{
+		for (int r = 0; r < 4; r++)
+		{
+			result[r][c] = a[r][0] * b[0][c] + a[r][1] * b[1][c] + a[r][2] * b[2][c] + a[r][3] * b[3][c];
+		}
+	}
+	for (int r = 0; r < 4; r++)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			out[r][c] = result[r][c];
+		}
+	}
+#endif
+}
+
+//   4  float: out = v * m
+inline void simdMultiplyVector(const float m[4][4], const float v[4], float out[4])
+{
+#ifdef GEOMETRY_SIMD_SSE
+	__m128 result = _mm_mul_ps(_mm_set1_ps(v[0]), _mm_load_ps(m[0]));
+	result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(v[1]), _mm_load_ps(m[1])));
+	result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(v[2]), _mm_load_ps(m[2])));
+	result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(v[3]), _mm_load_ps(m[3])));
+	_mm_store_ps(out, result);
+#else
+	float x = v[0], y = v[1], z = v[2], w = v[3];
+	out[0] = x * m[0][0] + y * m[1][0] + z * m[2][0] + w * m[3][0];
+	out[1] = x * m[0][1] + y * m[1][1] + z * m[2][1] + w * m[3][1];
+	out[2] = x * m[0][2] + y * m[1][2] + z * m[2][2] + w * m[3][2];
+	out[3] = x * m[0][3] + y * m[1][3] + z * m[2][3] + w * m[3][3];
+#endif
+}
+
+//    x, y, z, w
+inline void simdTransformBatch(const float m[4][4], const float* x, const float* y, const float* z, const float* w,
+	float* ox, float* oy, float* oz, float* ow, size_t count)
+{
+	size_t i = 0;
+
+#ifdef GEOMETRY_SIMD_AVX
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 vx = _mm256_loadu_ps(x + i);
+		__m256 vy = _mm256_loadu_ps(y + i);
+		__m256 vz = _mm256_loadu_ps(z + i);
+		__m256 vw = _mm256_loadu_ps(w + i);
+		float* outs[4] = { ox, oy, oz, ow };
+
+		for (int c = 0; c < 4; c++)
+		{
+			__m256 result = _mm256_mul_ps(vx, _mm256_set1_ps(m[0][c]));
+			result = _mm256_add_ps(result, _mm256_mul_ps(vy, _mm256_set1_ps(m[1][c])));
+			result = _mm256_add_ps(result, _mm256_mul_ps(vz, _mm256_set1_ps(m[2][c])));
+			result = _mm256_add_ps(result, _mm256_mul_ps(vw, _mm256_set1_ps(m[3][c])));
+			_mm256_storeu_ps(outs[c] + i, result);
+		}
+	}
+#endif
+#ifdef GEOMETRY_SIMD_SSE
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 vx = _mm_loadu_ps(x + i);
+		__m128 vy = _mm_loadu_ps(y + i);
+		__m128 vz = _mm_loadu_ps(z + i);
+		__m128 vw = _mm_loadu_ps(w + i);
+		float* outs[4] = { ox, oy, oz, ow };
+
+		for (int c = 0; c < 4; c++)
+		{
+			__m128 result = _mm_mul_ps(vx, _mm_set1_ps(m[0][c]));
+			result = _mm_add_ps(result, _mm_mul_ps(vy, _mm_set1_ps(m[1][c])));
+			result = _mm_add_ps(result, _mm_mul_ps(vz, _mm_set1_ps(m[2][c])));
+			result = _mm_add_ps(result, _mm_mul_ps(vw, _mm_set1_ps(m[3][c])));
+			_mm_storeu_ps(outs[c] + i, result);
+		}
+	}
+#endif
+	for (; i < count; i++)
+	{
+		float vx = x[i], vy = y[i], vz = z[i], vw = w[i];
+		ox[i] = vx * m[0][0] + vy * m[1][0] + vz * m[2][0] + vw * m[3][0];
+		oy[i] = vx * m[0][1] + vy * m[1][1] + vz * m[2][1] + vw * m[3][1];
+		oz[i] = vx * m[0][2] + vy * m[1][2] + vz * m[2][2] + vw * m[3][2];
+		ow[i] = vx * m[0][3] + vy * m[1][3] + vz * m[2][3] + vw * m[3][3];
+	}
+}
+
+//       : x = x / w * scaleX + offsetX
+inline void simdPerspectiveDivide(float* x, float* y, float* z, const float* w, size_t count,
+	float scaleX, float offsetX, float scaleY, float offsetY)
+{
+	size_t i = 0;
+
+#ifdef GEOMETRY_SIMD_AVX
+	__m256 sx8 = _mm256_set1_ps(scaleX), ox8 = _mm256_set1_ps(offsetX);
+	__m256 sy8 = _mm256_set1_ps(scaleY), oy8 = _mm256_set1_ps(offsetY);
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 invW = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_loadu_ps(w + i));
+		_mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(x + i), invW), sx8), ox8));
+		_mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(y + i), invW), sy8), oy8));
+		_mm256_storeu_ps(z + i, _mm256_mul_ps(_mm256_loadu_ps(z + i), invW));
+	}
+#endif
+#ifdef GEOMETRY_SIMD_SSE
+	__m128 sx4 = _mm_set1_ps(scaleX), ox4 = _mm_set1_ps(offsetX);
+	__m128 sy4 = _mm_set1_ps(scaleY), oy4 = _mm_set1_ps(offsetY);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 invW = _mm_div_ps(_mm_set1_ps(1.0f), _mm_loadu_ps(w + i));
+		_mm_storeu_ps(x + i, _mm_add_ps(_mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(x + i), invW), sx4), ox4));
+		_mm_storeu_ps(y + i, _mm_add_ps(_mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(y + i), invW), sy4), oy4));
+		_mm_storeu_ps(z + i, _mm_mul_ps(_mm_loadu_ps(z + i), invW));
+	}
+#endif
+	for (; i < count; i++)
+	{
+		float invW = 1.0f / w[i];
+		x[i] = x[i] * invW * scaleX + offsetX;
+		y[i] = y[i] * invW * scaleY + offsetY;
+		z[i] = z[i] * invW;
+	}
+}
+
+//    x, y, z
+inline float simdDotProduct(const float v1[4], const float v2[4])
+{
+#ifdef GEOMETRY_SIMD_SSE
+	__m128 mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	__m128 product = _mm_and_ps(_mm_mul_ps(_mm_load_ps(v1), _mm_load_ps(v2)), mask);
+	__m128 shuffled = _mm_shuffle_ps(product, product, _MM_SHUFFLE(2, 3, 0, 1));
+	__m128 sums = _mm_add_ps(product, shuffled);
+	shuffled = _mm_movehl_ps(shuffled, sums);
+	return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+#else
+	return v1[0] * v2[0] + v1[1] * v2[1] + v1[2] * v2[2];
+#endif
+}
+
+//    x, y, z; w   0
+inline void simdCrossProduct(const float v1[4], const float v2[4], float out[4])
+{
+#ifdef GEOMETRY_SIMD_SSE
+	__m128 a = _mm_load_ps(v1);
+	__m128 b = _mm_load_ps(v2);
+	__m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 c = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+	_mm_store_ps(out, _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1)));
+#else
+	float x = v1[1] * v2[2] - v1[2] * v2[1];
+	float y = v1[2] * v2[0] - v1[0] * v2[2];
+	float z = v1[0] * v2[1] - v1[1] * v2[0];
+	out[0] = x;
+	out[1] = y;
+	out[2] = z;
+	out[3] = 0.0f;
+#endif
+}
+
+#endif
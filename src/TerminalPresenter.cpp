@@ -0,0 +1,317 @@
+#include "TerminalPresenter.h"
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace
+{
+	//   ,     
+	const chrono::milliseconds keyHoldTime(120);
+	//        
+	const chrono::milliseconds titleInterval(500);
+	//  ESC   ,   
+	const chrono::milliseconds escapeTimeout(50);
+
+	//   Win32 (B=1, G=2, R=4, =8)    ANSI
+	inline int ansiColour(uint16_t colour)
+	{
+		int base = ((colour & 0x4) ? 1 : 0) | ((colour & 0x2) ? 2 : 0) | ((colour & 0x1) ? 4 : 0);
+		return (colour & 0x8) ? base + 60 : base;
+	}
+}
+
+TerminalPresenter::TerminalPresenter()
+{
+	width = height = 0;
+	rawMode = false;
+	screenActive = false;
+	closed = false;
+	titleChanged = false;
+	escapePending = false;
+}
+
+TerminalPresenter::~TerminalPresenter()
+{
+	restore();
+}
+
+bool TerminalPresenter::getTerminalSize(int16_t& width, int16_t& height)
+{
+	winsize size;
+
+	if (!isatty(STDOUT_FILENO) || ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) != 0 || size.ws_col == 0)
+	{
+		return false;
+	}
+	width = size.ws_col;
+	height = size.ws_row;
+	return true;
+}
+
+int16_t TerminalPresenter::create(int16_t width, int16_t height, int16_t /*fontW*/, int16_t /*fontH*/, const wstring& title)
+{
+	int16_t terminalWidth, terminalHeight;
+
+	if (!getTerminalSize(terminalWidth, terminalHeight))
+	{
+		return error(L"Output is not a terminal");
+	}
+	if (width > terminalWidth || height > terminalHeight)
+	{
+		return error(L"Screen size exceeds terminal size");
+	}
+	this->width = width;
+	this->height = height;
+	this->title = title;
+	titleChanged = true;
+
+	if (tcgetattr(STDIN_FILENO, &originalMode) == 0)
+	{
+		termios raw = originalMode;
+		raw.c_lflag &= ~(ICANON | ECHO | ISIG);
+		raw.c_iflag &= ~(IXON | ICRNL);
+		raw.c_cc[VMIN] = 0;
+		raw.c_cc[VTIME] = 0;
+		tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+		rawMode = true;
+	}
+
+	//  ,  ,     SGR
+	writeAll("\x1b[?1049h\x1b[?25l\x1b[2J\x1b[?1003h\x1b[?1006h");
+	screenActive = true;
+	frameDiff.reset(width, height);
+	frame.reserve(width * height * 4);
+	//   -    
+	dirtyRuns.reserve(height * ((width + 1) / 2));
+	return 0;
+}
+
+void TerminalPresenter::restore()
+{
+	if (screenActive)
+	{
+		writeAll("\x1b[0m\x1b[?1006l\x1b[?1003l\x1b[?25h\x1b[?1049l");
+		screenActive = false;
+	}
+	if (rawMode)
+	{
+		tcsetattr(STDIN_FILENO, TCSAFLUSH, &originalMode);
+		rawMode = false;
+	}
+}
+
+void TerminalPresenter::writeAll(const string& data)
+{
+	size_t written = 0;
+
+	while (written < data.size())
+	{
+		ssize_t result = write(STDOUT_FILENO, data.data() + written, data.size() - written);
+		if (result > 0)
+		{
+			written += result;
+			continue;
+		}
+
+		//   :     
+		if (result < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			pollfd output = { STDOUT_FILENO, POLLOUT, 0 };
+			poll(&output, 1, -1);
+			continue;
+		}
+		return;
+	}
+}
+
+int16_t TerminalPresenter::error(const wchar_t* msg)
+{
+	restore();
+	fwprintf(stderr, L"ERROR: %ls\n", msg);
+	return 1;
+}
+
+void TerminalPresenter::parseInput(int16_t* keyStates, bool* mouseStates, int16_t& mouseX, int16_t& mouseY)
+{
+	auto now = chrono::steady_clock::now();
+	size_t i = 0;
+
+	while (i < inputBuffer.size())
+	{
+		unsigned char c = inputBuffer[i];
+
+		if (c == 0x03)
+		{
+			closed = true;
+			i++;
+		}
+		else if (c == 0x1B)
+		{
+			if (i + 1 >= inputBuffer.size())
+			{
+				if (!escapePending)
+				{
+					escapePending = true;
+					escapeTime = now;
+				}
+				if (now - escapeTime < escapeTimeout)
+				{
+					break;
+				}
+				escapePending = false;
+				closed = true;
+				i++;
+				continue;
+			}
+			escapePending = false;
+			if (inputBuffer[i + 1] != '[')
+			{
+				i += 2;
+				continue;
+			}
+
+			//     CSI
+			size_t j = i + 2;
+			while (j < inputBuffer.size() && (inputBuffer[j] < 0x40 || inputBuffer[j] > 0x7E || (j == i + 2 && inputBuffer[j] == '<')))
+			{
+				j++;
+			}
+			if (j >= inputBuffer.size())
+			{
+				break;
+			}
+
+			// : ESC [ < b ; x ; y M|m
+			int button, x, y;
+			if (inputBuffer[i + 2] == '<' && sscanf(inputBuffer.c_str() + i + 3, "%d;%d;%d", &button, &x, &y) == 3)
+			{
+				mouseX = x - 1;
+				mouseY = y - 1;
+				if (!(button & 64))
+				{
+					bool pressed = inputBuffer[j] == 'M';
+					switch (button & 3)
+					{
+						case 0:
+							mouseStates[0] = pressed;
+							break;
+						case 1:
+							mouseStates[2] = pressed;
+							break;
+						case 2:
+							mouseStates[1] = pressed;
+							break;
+						default:
+							break;
+					}
+				}
+			}
+			i = j + 1;
+		}
+		else
+		{
+			keyTimes[toupper(c) & 0xFF] = now;
+			i++;
+		}
+	}
+	inputBuffer.erase(0, i);
+
+	for (int16_t k = 0; k < 256; k++)
+	{
+		keyStates[k] = (now - keyTimes[k] < keyHoldTime) ? static_cast<int16_t>(0x8000) : 0;
+	}
+	keyStates[VK_LBUTTON] = mouseStates[0] ? static_cast<int16_t>(0x8000) : 0;
+}
+
+void TerminalPresenter::pollInput(int16_t* keyStates, bool* mouseStates, int16_t& mouseX, int16_t& mouseY, bool& inFocus)
+{
+	char buf[256];
+	ssize_t count;
+
+	while ((count = read(STDIN_FILENO, buf, sizeof(buf))) > 0)
+	{
+		inputBuffer.append(buf, count);
+	}
+	parseInput(keyStates, mouseStates, mouseX, mouseY);
+	inFocus = true;
+}
+
+bool TerminalPresenter::waitForInput(uint32_t timeoutMs)
+{
+	pollfd input = { STDIN_FILENO, POLLIN, 0 };
+	return poll(&input, 1, static_cast<int>(timeoutMs)) > 0;
+}
+
+void TerminalPresenter::appendAttributes(uint16_t attributes)
+{
+	char buf[32];
+	snprintf(buf, sizeof(buf), "\x1b[%d;%dm", 30 + ansiColour(attributes & 0x0F), 40 + ansiColour((attributes >> 4) & 0x0F));
+	frame += buf;
+}
+
+void TerminalPresenter::present(const CHAR_INFO* buffer, int16_t width, int16_t /*height*/)
+{
+	frame.clear();
+	frameDiff.compute(buffer, dirtyRuns, 4);
+
+	//       write()
+	int16_t cursorX = -1, cursorY = -1;
+	int32_t attributes = -1;
+	for (auto& run : dirtyRuns)
+	{
+		if (run.y != cursorY || run.x1 != cursorX)
+		{
+			char buf[32];
+			snprintf(buf, sizeof(buf), "\x1b[%d;%dH", run.y + 1, run.x1 + 1);
+			frame += buf;
+		}
+
+		const CHAR_INFO* cell = &buffer[run.y * width + run.x1];
+		for (int16_t x = run.x1; x <= run.x2; x++, cell++)
+		{
+			if (cell->Attributes != attributes)
+			{
+				attributes = cell->Attributes;
+				appendAttributes(cell->Attributes);
+			}
+			appendUtf8(frame, cell->Char.UnicodeChar);
+		}
+		cursorX = run.x2 + 1;
+		cursorY = run.y;
+	}
+
+	auto now = chrono::steady_clock::now();
+	if (titleChanged && now - lastTitleUpdate >= titleInterval)
+	{
+		frame += "\x1b]0;";
+		for (wchar_t c : title)
+		{
+			appendUtf8(frame, c);
+		}
+		frame += "\x07";
+		titleChanged = false;
+		lastTitleUpdate = now;
+	}
+
+	if (!frame.empty())
+	{
+		writeAll(frame);
+	}
+}
+
+void TerminalPresenter::setTitle(const wstring& title)
+{
+	if (title != this->title)
+	{
+		this->title = title;
+		titleChanged = true;
+	}
+}
@@ -0,0 +1,53 @@
+#ifndef _TERMINAL_PRESENTER_H_
+#define _TERMINAL_PRESENTER_H_
+
+#include "Presenter.h"
+#include <atomic>
+#include <chrono>
+#include <termios.h>
+
+//    POSIX  ANSI/VT 
+class TerminalPresenter : public Presenter
+{
+private:
+	int16_t width, height;
+	bool rawMode;
+	//   ,     
+	bool screenActive;
+	atomic<bool> closed;
+	termios originalMode;
+	FrameDiff frameDiff;
+	vector<DirtyRun> dirtyRuns;
+	string frame;
+	string inputBuffer;
+	wstring title;
+	bool titleChanged;
+	bool escapePending;
+	chrono::steady_clock::time_point escapeTime;
+	chrono::steady_clock::time_point lastTitleUpdate;
+	chrono::steady_clock::time_point keyTimes[256];
+
+	void restore();
+	void writeAll(const string& data);
+	void appendAttributes(uint16_t attributes);
+	void parseInput(int16_t* keyStates, bool* mouseStates, int16_t& mouseX, int16_t& mouseY);
+
+public:
+	TerminalPresenter();
+	~TerminalPresenter();
+
+	static bool getTerminalSize(int16_t& width, int16_t& height);
+
+	virtual int16_t create(int16_t width, int16_t height, int16_t fontW, int16_t fontH, const wstring& title) override;
+	virtual void pollInput(int16_t* keyStates, bool* mouseStates, int16_t& mouseX, int16_t& mouseY, bool& inFocus) override;
+	virtual void present(const CHAR_INFO* buffer, int16_t width, int16_t height) override;
+	virtual void setTitle(const wstring& title) override;
+	virtual int16_t error(const wchar_t* msg) override;
+	virtual bool isOpen() override
+	{
+		return !closed;
+	}
+	virtual bool waitForInput(uint32_t timeoutMs) override;
+};
+
+#endif
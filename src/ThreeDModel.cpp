@@ -1,6 +1,72 @@
 #include "ThreeDModel.h"
+#include <cmath>
+#include <cstdio>
 
-void ThreeDModel::userCreateHandle()
+ThreeDModel::ThreeDModel()
+{
+	gridInstances = 0;
+	lodEnabled = true;
+	cameraNode = scene.addNode(SceneGraph::NO_PARENT, makeIdentity());
+	sceneStateValid = false;
+}
+
+void ThreeDModel::addModelFile(const string& path)
+{
+	modelFiles.push_back(path);
+}
+
+size_t ThreeDModel::addInstance(uint32_t mesh, float x, float y, float z, float scale)
+{
+	matrix4x4 ScalingMatrix = makeScale(scale, scale, scale);
+	matrix4x4 TranslationMatrix = makeTranslation(x, y, z);
+	uint32_t placement = scene.addNode(cameraNode, ScalingMatrix * TranslationMatrix);
+	uint32_t spin = scene.addNode(placement, makeIdentity());
+	scene.attachMesh(spin, mesh);
+	spinNodes.push_back(spin);
+
+	//         
+	instances.push_back({ spin });
+	sceneStateValid = false;
+	return instances.size() - 1;
+}
+
+bool ThreeDModel::convertModelFile(const string& objPath, const string& binaryPath)
+{
+	Mesh mesh;
+	return loadMeshObj(objPath, mesh) && saveMeshBinary(binaryPath, mesh);
+}
+
+bool ThreeDModel::loadModel(const string& path, Mesh& mesh)
+{
+	size_t dot = path.find_last_of('.');
+	string extension = (dot == string::npos) ? "" : path.substr(dot);
+
+	if (extension == ".obj" || extension == ".OBJ")
+	{
+		return loadMeshObj(path, mesh);
+	}
+	return loadMeshBinary(path, mesh);
+}
+
+void ThreeDModel::normaliseModel(Mesh& mesh, float size)
+{
+	//     [0, size]    
+	VertexBuffer& v = mesh.vertices;
+	float minX = *min_element(v.x.begin(), v.x.end()), maxX = *max_element(v.x.begin(), v.x.end());
+	float minY = *min_element(v.y.begin(), v.y.end()), maxY = *max_element(v.y.begin(), v.y.end());
+	float minZ = *min_element(v.z.begin(), v.z.end()), maxZ = *max_element(v.z.begin(), v.z.end());
+	float extent = max(maxX - minX, max(maxY - minY, maxZ - minZ));
+	float k = (extent > 0.0f) ? size / extent : 1.0f;
+
+	for (size_t i = 0; i < v.size(); i++)
+	{
+		v.x[i] = (v.x[i] - minX) * k;
+		v.y[i] = (v.y[i] - minY) * k;
+		v.z[i] = (v.z[i] - minZ) * k;
+	}
+}
+
+void ThreeDModel::createDefaultShapes()
 {
 	shapes.resize(2);
 
@@ -26,9 +92,77 @@ void ThreeDModel::userCreateHandle()
 			{ 1.0f, 0.0f, 2.0f,    1.0f, 2.0f, 1.0f,    0.0f, 0.0f, 0.0f }
 	};
 
+	for (auto& sh : shapes)
+	{
+		sh.buildIndexBuffer();
+		sh.orientOutward();
+	}
+}
+
+void ThreeDModel::createInstanceGrid(size_t count, float extent)
+{
+	//    extent     ,  
+	size_t columns = static_cast<size_t>(ceilf(sqrtf(static_cast<float>(count))));
+	float step = extent / columns;
+	float start = -0.5f * extent;
+
+	instances.reserve(instances.size() + count);
+	for (size_t i = 0; i < count; i++)
+	{
+		float x = start + step * (i % columns);
+		float y = start + step * (i / columns);
+		addInstance(static_cast<uint32_t>(i % shapes.size()), x, y, 0.0f, 0.4f * step);
+	}
+}
+
+void ThreeDModel::userCreateHandle()
+{
+	for (auto& path : modelFiles)
+	{
+		Mesh mesh;
+		if (loadModel(path, mesh))
+		{
+			normaliseModel(mesh, 2.0f);
+			shapes.push_back(move(mesh));
+		}
+		else
+		{
+			fprintf(stderr, "Model load error: %s\n", path.c_str());
+		}
+	}
+
+	if (shapes.empty())
+	{
+		createDefaultShapes();
+	}
+	for (auto& sh : shapes)
+	{
+		sh.buildBvh();
+		//       
+		if (lodEnabled)
+		{
+			sh.buildLods();
+		}
+	}
+
+	//        ,    
+	if (instances.empty() && gridInstances)
+	{
+		createInstanceGrid(gridInstances, 2.0f * INSTANCE_SPACING);
+	}
+	if (instances.empty())
+	{
+		for (size_t i = 0; i < shapes.size(); i++)
+		{
+			addInstance(static_cast<uint32_t>(i), -INSTANCE_SPACING * i, 0.0f, 0.0f);
+		}
+	}
+
 	matrixProjection = makeProjection(90.0f, static_cast<float>(getConsoleHeight()) / static_cast<float>(getConsoleWidth()), 1.0f, 10.0f);
+	viewVolume.projection = matrixProjection;
+	viewVolume.zNear = 1.0f;
+	viewVolume.zFar = 10.0f;
 	sx = sy = 0.4f;
-	sa = -4.0f;
 	sm = 0.1f;
 
 	light.x = 1.0f;
@@ -38,37 +172,57 @@ void ThreeDModel::userCreateHandle()
 	scale = 1.0f;							
 	coordX = 0.5f; coordY = 0.5f; coordZ = 4.0f;
 	thetaX = thetaY = thetaZ = 0.0f;
+	previousViewState = captureViewState();
 }
 
-void ThreeDModel::userUpdateHandle(float fElapsedTime)
+ThreeDModel::ViewState ThreeDModel::captureViewState()
 {
-	fill(0, 0, getConsoleWidth(), getConsoleHeight());
-	fill(0, consoleHeight / 2, consoleWidth, consoleHeight, PIXEL_SOLID, BG_BLUE);
+	return { scale, coordX, coordY, coordZ, thetaX, thetaY, thetaZ, getRenderMode(), getBackfaceCulling(), instances.size() };
+}
+
+//       
+ThreeDModel::ViewState ThreeDModel::interpolateViewState(float alpha)
+{
+	ViewState state = captureViewState();
+	auto lerp = [alpha](float a, float b) { return (a == b) ? b : a + (b - a) * alpha; };
+	state.scale = lerp(previousViewState.scale, scale);
+	state.coordX = lerp(previousViewState.coordX, coordX);
+	state.coordY = lerp(previousViewState.coordY, coordY);
+	state.coordZ = lerp(previousViewState.coordZ, coordZ);
+	state.thetaX = lerp(previousViewState.thetaX, thetaX);
+	state.thetaY = lerp(previousViewState.thetaY, thetaY);
+	state.thetaZ = lerp(previousViewState.thetaZ, thetaZ);
+	return state;
+}
+
+void ThreeDModel::userFixedUpdateHandle(float fFixedStep)
+{
+	previousViewState = captureViewState();
 
 	//   
 	if (getKey(L'W').bHeld)
 	{
-		thetaX += 8.0f * fElapsedTime;
+		thetaX += 8.0f * fFixedStep;
 	}
 	if (getKey(L'S').bHeld)
 	{
-		thetaX -= 8.0f * fElapsedTime;
+		thetaX -= 8.0f * fFixedStep;
 	}
 	if (getKey(L'A').bHeld)
 	{
-		thetaY += 8.0f * fElapsedTime;
+		thetaY += 8.0f * fFixedStep;
 	}
 	if (getKey(L'D').bHeld)
 	{
-		thetaY -= 8.0f * fElapsedTime;
+		thetaY -= 8.0f * fFixedStep;
 	}
 	if (getKey(L'Q').bHeld)
 	{
-		thetaZ += 8.0f * fElapsedTime;
+		thetaZ += 8.0f * fFixedStep;
 	}
 	if (getKey(L'E').bHeld)
 	{
-		thetaZ -= 8.0f * fElapsedTime;
+		thetaZ -= 8.0f * fFixedStep;
 	}
 
 	//  
@@ -119,70 +273,183 @@ void ThreeDModel::userUpdateHandle(float fElapsedTime)
 			}
 		}
 	}
+}
 
-	matrix4x4 matRotX, matRotY, matRotZ;
-	matRotX = makeRotationX(thetaX * 0.5f);
-	matRotY = makeRotationY(thetaY * 0.5f);
-	matRotZ = makeRotationZ(thetaZ * 0.5f);
+bool ThreeDModel::userUpdateHandle(float /*fElapsedTime*/)
+{
+	//     
+	if (getKey(L'R').bPressed)
+	{
+		setRenderMode(getRenderMode() == RENDER_PAINTER ? RENDER_ZBUFFER : RENDER_PAINTER);
+	}
+	if (getKey(L'C').bPressed)
+	{
+		setBackfaceCulling(!getBackfaceCulling());
+	}
+	if (getKey(L'L').bPressed)
+	{
+		lodEnabled = !lodEnabled;
+		invalidate();
+	}
 
-	matrix4x4 ScalingMatrix;
-	ScalingMatrix = makeScale(scale, scale, scale);
+	//         
+	ViewState viewState = interpolateViewState(scheduler.getAlpha());
+	if (!redrawRequested && viewState == lastViewState)
+	{
+		return false;
+	}
+	lastViewState = viewState;
+	redrawRequested = false;
 
-	matrix4x4 TranslationMatrix;
-	TranslationMatrix = makeTranslation(0.0f, 0.0f, coordZ);
+	{
+		PROFILE_SCOPE(profiler, STAGE_FILL);
+		fill(0, 0, getConsoleWidth(), getConsoleHeight());
+		fill(0, consoleHeight / 2, consoleWidth, consoleHeight, PIXEL_SOLID, BG_BLUE);
+	}
+	if (getRenderMode() == RENDER_ZBUFFER)
+	{
+		PROFILE_SCOPE(profiler, STAGE_FILL);
+		clearDepth();
+	}
 
-	matrix4x4 WorldMatrix;
-	WorldMatrix = makeIdentity();
-	WorldMatrix = matRotY * matRotX * matRotZ * ScalingMatrix * TranslationMatrix;
+	FrameVector<triangle> vecShadowCasters(frameArena);
+	FrameVector<triangle> vecSceneTriangles(frameArena);
 
-	vector<triangle> vecTrianglesToRaster;
+	//    
+	viewVolume.scaleX = -(0.1f + sx) * static_cast<float>(getConsoleWidth());
+	viewVolume.scaleY = -(0.1f + sy) * static_cast<float>(getConsoleHeight());
+	viewVolume.offsetX = viewVolume.offsetY = 0.0f;
 
-	float  t = 0.0f;
-	int16_t triColor = FG_RED;
-	int16_t countTris = 0;
-	for (auto& sh: shapes) 
 	{
-		for (auto tri : sh.tris)
-		{
-			triangle triProjected, triTransformed;
+		PROFILE_SCOPE(profiler, STAGE_TRANSFORM);
 
-			for (int16_t i = 0; i < 3; i++)
+		//          
+		updateSceneTransforms(viewState);
+		instanceBounds.resize(instances.size());
+		for (size_t i = 0; i < instances.size(); i++)
+		{
+			matrix4x4 ViewMatrix = scene.getWorld(instances[i].node);
+			instanceBounds[i].reset();
+			for (uint32_t mesh : scene.getNode(instances[i].node).meshes)
 			{
-				triTransformed.points[i] = multiplyMatrix(WorldMatrix, tri.points[i]);
+				instanceBounds[i].expand(transformBounds(shapes[mesh].bvh.getBounds(), ViewMatrix));
+			}
+		}
+		if (sceneBvh.size() != instances.size())
+		{
+			sceneBvh.build(instanceBounds, 1);
+		}
+		else
+		{
+			sceneBvh.refit(instanceBounds);
+		}
+
+		//      
+		float planes[6][4];
+		makeFrustumPlanes(matrixProjection, viewVolume, planes);
+		sceneBvh.query(planes, 6, visibleRanges);
+		visibleInstances.clear();
+		for (auto& range : visibleRanges)
+		{
+			visibleInstances.insert(visibleInstances.end(), sceneBvh.getOrder().begin() + range.first,
+				sceneBvh.getOrder().begin() + range.first + range.count);
+		}
 
-				// 3D  2D
-				triProjected.points[i] = multiplyMatrix(matrixProjection, triTransformed.points[i]);
-				triProjected.points[i] = triProjected.points[i] / triProjected.points[i].w;
-				triProjected.points[i].x *= -1.0f;
-				triProjected.points[i].y *= -1.0f;
+		//       ,      
+		sort(visibleInstances.begin(), visibleInstances.end(), [this](uint32_t a, uint32_t b)
+			{
+				float za = instanceBounds[a].min[2] + instanceBounds[a].max[2];
+				float zb = instanceBounds[b].min[2] + instanceBounds[b].max[2];
+				return (za != zb) ? za > zb : a < b;
 			}
+		);
+	}
 
-			//    
-			for (int16_t i = 0; i < 3; i++)
+	//     :     
+	FrameVector<FrameVector<triangle>> shapeTriangles(frameArena);
+	shapeTriangles.reserve(visibleInstances.size());
+	instanceBarycenters.resize(visibleInstances.size());
+	for (size_t n = 0; n < visibleInstances.size(); n++)
+	{
+		matrix4x4 ViewMatrix = scene.getWorld(instances[visibleInstances[n]].node);
+		shapeTriangles.emplace_back(frameArena);
+		FrameVector<triangle>& vecTrianglesToRaster = shapeTriangles.back();
+		size_t firstCaster = vecShadowCasters.size();
+
+		//        
+		for (uint32_t meshIndex : scene.getNode(instances[visibleInstances[n]].node).meshes)
+		{
+			Mesh& mesh = shapes[meshIndex];
+			Mesh& sh = lodEnabled ? selectLod(mesh, instanceBounds[visibleInstances[n]], viewVolume) : mesh;
+
+			PROFILE_SCOPE(profiler, STAGE_TRANSFORM);
+
+			//       
+			transformVertices(sh.vertices, ViewMatrix, viewSpace);
+			transformVertices(viewSpace, matrixProjection, projected);
+			projectVertices(projected, viewVolume.scaleX, viewVolume.offsetX, viewVolume.scaleY, viewVolume.offsetY);
+
+			//       
+			matrix4x4 ObjectClipMatrix;
+			ObjectClipMatrix = ViewMatrix * matrixProjection;
+			float planes[6][4];
+			makeFrustumPlanes(ObjectClipMatrix, viewVolume, planes);
+			sh.bvh.query(planes, 6, visibleRanges);
+
+			//       ,   
+			for (auto& range : visibleRanges)
 			{
-				triProjected.points[i].x += coordX + t;
-				triProjected.points[i].y += coordY;
-				triProjected.points[i].x *= (0.1f + sx) * static_cast<float>(getConsoleWidth());
-				triProjected.points[i].y *= (0.1f + sy) * static_cast<float>(getConsoleHeight());
-				barycenter += triProjected.points[i];
+				cullTriangles(sh, viewSpace, projected, viewVolume, vecTrianglesToRaster, vecShadowCasters,
+					BG_BLUE, FG_RED, range.first, range.count);
 			}
-			countTris++;
+		}
 
-			//  
-			triColor = triColor == BG_BLUE ? FG_RED : BG_BLUE;
-			triProjected.col = triColor;
-			vecTrianglesToRaster.push_back(triProjected);
+		Point3D barycenter;
+		for (size_t i = firstCaster; i < vecShadowCasters.size(); i++)
+		{
+			for (int16_t k = 0; k < 3; k++)
+			{
+				barycenter += vecShadowCasters[i].points[k];
+			}
 		}
+		barycenter /= max<size_t>(vecShadowCasters.size() - firstCaster, 1) * 3;
+		instanceBarycenters[n] = barycenter;
+	}
 
-		barycenter /= countTris * 3;
+	//         
+	{
+		PROFILE_SCOPE(profiler, STAGE_SHADOW);
+		drawShadow(vecShadowCasters, light);
+	}
 
-		sort(vecTrianglesToRaster.begin(), vecTrianglesToRaster.end(), [](triangle& t1, triangle& t2)
+	//      ,      
+	if (getRenderMode() == RENDER_ZBUFFER)
+	{
+		for (auto& tris : shapeTriangles)
+		{
+			PROFILE_SCOPE(profiler, STAGE_SHADOW);
+			for (auto& tri : tris)
 			{
-				float z1 = (t1.points[0].z + t1.points[1].z + t1.points[2].z) / 3.0f;
-				float z2 = (t2.points[0].z + t2.points[1].z + t2.points[2].z) / 3.0f;
-				return z1 > z2;
+				Point3D center = (tri.points[0] + tri.points[1] + tri.points[2]) / 3.0f;
+				center.w = (tri.points[0].w + tri.points[1].w + tri.points[2].w) / 3.0f;
+				tri.sym = isInShadow(center) ? PIXEL_HALF : PIXEL_SOLID;
 			}
-		);
+			vecSceneTriangles.insert(vecSceneTriangles.end(), tris.begin(), tris.end());
+		}
+
+		PROFILE_SCOPE(profiler, STAGE_FILL);
+		rasterizeTrianglesTiled(vecSceneTriangles);
+		return true;
+	}
+
+	for (size_t n = 0; n < shapeTriangles.size(); n++)
+	{
+		FrameVector<triangle>& vecTrianglesToRaster = shapeTriangles[n];
+
+		{
+			PROFILE_SCOPE(profiler, STAGE_SORT);
+			sortByDepth(vecTrianglesToRaster);
+		}
 
 		for (auto& tri : vecTrianglesToRaster)
 		{
@@ -193,14 +460,51 @@ void ThreeDModel::userUpdateHandle(float fElapsedTime)
 			}
 		}
 
-		drawShadow(vecTrianglesToRaster, light);
+		{
+			PROFILE_SCOPE(profiler, STAGE_PAINT);
+			Point3D viewPoint = { static_cast<float>(consoleWidth) / 2.0f, static_cast<float>(consoleHeight) / 2.0f, -100.0f };
+			paintAlgorithm(vecTrianglesToRaster, viewPoint, instanceBarycenters[n], PIXEL_SOLID, FG_RED);
+		}
+	}
+	return true;
+}
 
-		Point3D viewPoint = { static_cast<float>(consoleWidth) / 2.0f, static_cast<float>(consoleHeight) / 2.0f, -100.0f };
-		paintAlgorithm(vecTrianglesToRaster, viewPoint, barycenter, PIXEL_SOLID, FG_RED);
-		
-		t += 5.0f + sa;
-		countTris = 0;
-		barycenter = 0.0f;
-		vecTrianglesToRaster.clear();
+void ThreeDModel::updateSceneTransforms(const ViewState& state)
+{
+	//       :    
+	if (!sceneStateValid || state.thetaX != sceneState.thetaX || state.thetaY != sceneState.thetaY ||
+		state.thetaZ != sceneState.thetaZ || state.scale != sceneState.scale)
+	{
+		//       ,      
+		matrix4x4 RotationScaleMatrix;
+		if (state.thetaX != thetaX || state.thetaY != thetaY || state.thetaZ != thetaZ)
+		{
+			quaternion from = makeQuaternionEuler(previousViewState.thetaX * 0.5f, previousViewState.thetaY * 0.5f, previousViewState.thetaZ * 0.5f);
+			quaternion to = makeQuaternionEuler(thetaX * 0.5f, thetaY * 0.5f, thetaZ * 0.5f);
+			RotationScaleMatrix = makeRotationQuaternion(slerp(from, to, scheduler.getAlpha()), state.scale);
+		}
+		else
+		{
+			RotationScaleMatrix = makeRotationEuler(state.thetaX * 0.5f, state.thetaY * 0.5f, state.thetaZ * 0.5f, state.scale);
+		}
+		for (uint32_t node : spinNodes)
+		{
+			scene.setLocal(node, RotationScaleMatrix);
+		}
+	}
+
+	//  :          , x' = x - coordX * z / P00
+	if (!sceneStateValid || state.coordX != sceneState.coordX || state.coordY != sceneState.coordY ||
+		state.coordZ != sceneState.coordZ)
+	{
+		matrix4x4 TranslationMatrix = makeTranslation(0.0f, 0.0f, state.coordZ);
+		matrix4x4 ShearMatrix = makeIdentity();
+		ShearMatrix.m[2][0] = -state.coordX / matrixProjection.m[0][0];
+		ShearMatrix.m[2][1] = -state.coordY / matrixProjection.m[1][1];
+		scene.setLocal(cameraNode, TranslationMatrix * ShearMatrix);
 	}
-}
\ No newline at end of file
+
+	sceneState = state;
+	sceneStateValid = true;
+	scene.update();
+}
@@ -2,21 +2,95 @@
 #define _NEW_GRAPHICS_H_
 
 #include "Geometry.h"
+#include "SceneGraph.h"
+
+//        
+const float INSTANCE_SPACING = 8.0f;
 
 class ThreeDModel : public Geometry
 {
-private:
+protected:
+	//  :  ,     
+	struct Instance
+	{
+		uint32_t node;
+	};
+
+	// ,    
+	struct ViewState
+	{
+		float scale;
+		float coordX, coordY, coordZ;
+		float thetaX, thetaY, thetaZ;
+		RENDER_MODE renderMode;
+		bool cullBackfaces;
+		size_t instanceCount;
+
+		bool operator==(const ViewState& obj) const
+		{
+			return scale == obj.scale && coordX == obj.coordX && coordY == obj.coordY && coordZ == obj.coordZ &&
+				thetaX == obj.thetaX && thetaY == obj.thetaY && thetaZ == obj.thetaZ &&
+				renderMode == obj.renderMode && cullBackfaces == obj.cullBackfaces && instanceCount == obj.instanceCount;
+		}
+	};
+
 	float scale;
 	float coordX, coordY, coordZ;
 	float thetaX, thetaY, thetaZ;
-	float sx, sy, sm, sa;
+	float sx, sy, sm;
 	Point3D light;
-	Point3D barycenter;
 	vector<Mesh> shapes;
+	vector<Instance> instances;
+	size_t gridInstances;
+	bool lodEnabled;
+	//  -  ,        
+	SceneGraph scene;
+	uint32_t cameraNode;
+	vector<uint32_t> spinNodes;
+	ViewState sceneState;
+	bool sceneStateValid;
+	VertexBuffer viewSpace;
+	VertexBuffer projected;
 	matrix4x4 matrixProjection;
+	ViewVolume viewVolume;
+	Bvh sceneBvh;
+	vector<Bvh::Bounds> instanceBounds;
+	vector<Bvh::Range> visibleRanges;
+	vector<uint32_t> visibleInstances;
+	vector<Point3D> instanceBarycenters;
+	vector<string> modelFiles;
+	ViewState lastViewState;
+	ViewState previousViewState;
+
+	ViewState captureViewState();
+	ViewState interpolateViewState(float alpha);
+
+	void createDefaultShapes();
+	void createInstanceGrid(size_t count, float extent);
+	void updateSceneTransforms(const ViewState& state);
+	bool loadModel(const string& path, Mesh& mesh);
+	void normaliseModel(Mesh& mesh, float size);
 
 	virtual void userCreateHandle() override;
-	virtual void userUpdateHandle(float fElapsedTime) override;
+	virtual void userFixedUpdateHandle(float fFixedStep) override;
+	virtual bool userUpdateHandle(float fElapsedTime) override;
+
+public:
+	ThreeDModel();
+
+	void addModelFile(const string& path);
+	size_t addInstance(uint32_t mesh, float x, float y, float z, float scale = 1.0f);
+	//   count       
+	void setInstanceGrid(size_t count)
+	{
+		gridInstances = count;
+	}
+	//         
+	void setLodEnabled(bool value)
+	{
+		lodEnabled = value;
+	}
+	bool convertModelFile(const string& objPath, const string& binaryPath);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool()
+{
+	jobCall = nullptr;
+	jobTask = nullptr;
+	nextJob = 0;
+	jobCount = 0;
+	activeWorkers = 0;
+	generation = 0;
+	stopping = false;
+}
+
+WorkerPool::~WorkerPool()
+{
+	stop();
+}
+
+void WorkerPool::start(size_t threadCount)
+{
+	stop();
+	stopping = false;
+
+	//     .     ,    
+	for (size_t i = 1; i < threadCount; i++)
+	{
+		workers.emplace_back(&WorkerPool::workerLoop, this, generation);
+	}
+}
+
+void WorkerPool::stop()
+{
+	{
+		lock_guard<mutex> lock(poolMutex);
+		stopping = true;
+	}
+	wakeCondition.notify_all();
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+	workers.clear();
+}
+
+void WorkerPool::runJobs()
+{
+	size_t index;
+	while ((index = nextJob.fetch_add(1)) < jobCount)
+	{
+		jobCall(jobTask, index);
+	}
+}
+
+void WorkerPool::workerLoop(uint64_t seenGeneration)
+{
+	while (true)
+	{
+		{
+			unique_lock<mutex> lock(poolMutex);
+			wakeCondition.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+			if (stopping)
+			{
+				return;
+			}
+			seenGeneration = generation;
+		}
+
+		runJobs();
+
+		{
+			lock_guard<mutex> lock(poolMutex);
+			activeWorkers--;
+		}
+		doneCondition.notify_one();
+	}
+}
+
+void WorkerPool::dispatch(size_t count, const void* task, void (*call)(const void*, size_t))
+{
+	{
+		lock_guard<mutex> lock(poolMutex);
+		jobCall = call;
+		jobTask = task;
+		jobCount = count;
+		nextJob = 0;
+		activeWorkers = workers.size();
+		generation++;
+	}
+	wakeCondition.notify_all();
+
+	runJobs();
+
+	unique_lock<mutex> lock(poolMutex);
+	doneCondition.wait(lock, [&]() { return activeWorkers == 0; });
+}
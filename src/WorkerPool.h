@@ -0,0 +1,59 @@
+#ifndef _WORKER_POOL_H_
+#define _WORKER_POOL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//       
+class WorkerPool
+{
+private:
+	vector<thread> workers;
+	mutex poolMutex;
+	condition_variable wakeCondition;
+	condition_variable doneCondition;
+	//    ,      
+	void (*jobCall)(const void*, size_t);
+	const void* jobTask;
+	atomic<size_t> nextJob;
+	size_t jobCount;
+	size_t activeWorkers;
+	uint64_t generation;
+	bool stopping;
+
+	void workerLoop(uint64_t seenGeneration);
+	void runJobs();
+	void dispatch(size_t count, const void* task, void (*call)(const void*, size_t));
+
+public:
+	WorkerPool();
+	~WorkerPool();
+
+	void start(size_t threadCount);
+	void stop();
+	size_t getThreadCount()
+	{
+		return workers.size() + 1;
+	}
+	template <class Task>
+	void run(size_t count, const Task& task)
+	{
+		if (workers.empty() || count <= 1)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				task(i);
+			}
+			return;
+		}
+		dispatch(count, &task, [](const void* obj, size_t index) { (*static_cast<const Task*>(obj))(index); });
+	}
+};
+
+#endif
@@ -1,12 +1,107 @@
 #include "ThreeDModel.h"
+#include "HeadlessPresenter.h"
+#ifndef _WIN32
+#include "TerminalPresenter.h"
+#endif
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
-int main()
+int main(int argc, char* argv[])
 {
 	ThreeDModel model;
+	HeadlessPresenter* headless = nullptr;
+	size_t threads = thread::hardware_concurrency();
+	const char* profilePath = nullptr;
+	float targetFps = -1.0f;
+
+	for (int i = 1; i < argc; i++)
+	{
+		// --headless <> []
+		if (!strcmp(argv[i], "--headless") && i + 1 < argc)
+		{
+			const char* dumpPath = (i + 2 < argc && argv[i + 2][0] != '-') ? argv[i + 2] : "";
+			headless = new HeadlessPresenter(dumpPath);
+			model.setPresenter(headless);
+			model.setFrameLimit(strtoul(argv[i + 1], nullptr, 10));
+			i += dumpPath[0] ? 2 : 1;
+		}
+		else if (!strcmp(argv[i], "--zbuffer"))
+		{
+			model.setRenderMode(RENDER_ZBUFFER);
+		}
+		// --threads <  >
+		else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+		{
+			threads = atoi(argv[++i]);
+		}
+		// --profile <.csv | .json>
+		else if (!strcmp(argv[i], "--profile") && i + 1 < argc)
+		{
+			profilePath = argv[++i];
+			model.getProfiler().setEnabled(true);
+		}
+		// --fps < , 0 -  >
+		else if (!strcmp(argv[i], "--fps") && i + 1 < argc)
+		{
+			targetFps = static_cast<float>(atof(argv[++i]));
+		}
+		// --instances <    >
+		else if (!strcmp(argv[i], "--instances") && i + 1 < argc)
+		{
+			model.setInstanceGrid(strtoul(argv[++i], nullptr, 10));
+		}
+		// --subcell <half | braille>
+		else if (!strcmp(argv[i], "--subcell") && i + 1 < argc)
+		{
+			i++;
+			model.setSubcellMode(!strcmp(argv[i], "braille") ? SUBCELL_BRAILLE : (!strcmp(argv[i], "half") ? SUBCELL_HALF_BLOCK : SUBCELL_OFF));
+		}
+		// --no-lod:   
+		else if (!strcmp(argv[i], "--no-lod"))
+		{
+			model.setLodEnabled(false);
+		}
+		// --model <.obj | .kgkm>
+		else if (!strcmp(argv[i], "--model") && i + 1 < argc)
+		{
+			model.addModelFile(argv[++i]);
+		}
+		// --convert <.obj> <.kgkm>
+		else if (!strcmp(argv[i], "--convert") && i + 2 < argc)
+		{
+			bool ok = model.convertModelFile(argv[i + 1], argv[i + 2]);
+			printf("%s: %s\n", argv[i + 2], ok ? "ok" : "error");
+			return ok ? 0 : 1;
+		}
+	}
 	
-	if (!model.constructConsole(400, 250, 2, 2, L"3D model"))
+	model.setThreadCount(threads);
+	//      60 ,     
+	model.getScheduler().setTargetFps(targetFps >= 0.0f ? targetFps : (headless ? 0.0f : 60.0f));
+
+	int16_t width = 400, height = 250;
+#ifndef _WIN32
+	//     
+	if (!headless && TerminalPresenter::getTerminalSize(width, height))
+	{
+		width = min<int16_t>(width, 400);
+		height = min<int16_t>(height - 1, 250);
+	}
+#endif
+
+	if (!model.constructConsole(width, height, 2, 2, L"3D model"))
 	{
 		model.run();
 	}
+	if (profilePath)
+	{
+		model.getProfiler().exportFile(profilePath);
+	}
+	if (headless)
+	{
+		printf("frames: %u, FPS: %.2f, cells per frame: %.1f\n", headless->getFrameCount(), headless->getFramesPerSecond(),
+			headless->getFrameCount() ? static_cast<double>(headless->getCellsPresented()) / headless->getFrameCount() : 0.0);
+	}
 	return 0;
-}
\ No newline at end of file
+}